@@ -0,0 +1,104 @@
+#include "Hq/Ecs/RegistryDelta.h"
+#include "Hq/Ecs/RegistrySnapshot.h"
+#include "microbench/microbench.h"
+
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct Position
+{
+    float x, y, z;
+};
+
+struct Velocity
+{
+    float x, y, z;
+};
+
+struct Health
+{
+    u32 value;
+    u32 team;
+};
+
+constexpr size_t kEntityCount = 100000;
+constexpr size_t kTickCount   = 30;
+
+// churn-heavy world: every tick 20% of the entities move, 5% get hit and 1% die and respawn
+struct World
+{
+    entt::registry            registry;
+    std::vector<entt::entity> alive;
+    std::mt19937              rng {1234};
+
+    void spawn()
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<Position>(entity, Position {float(rng() % 1000), 0.f, float(rng() % 1000)});
+        registry.emplace<Velocity>(entity, Velocity {1.f, 0.f, 0.5f});
+        registry.emplace<Health>(entity, Health {100, rng() % 4});
+        alive.push_back(entity);
+    }
+
+    void tick()
+    {
+        for (size_t i = 0; i < kEntityCount / 5; ++i)
+        {
+            const entt::entity entity   = alive[rng() % alive.size()];
+            Position&          position = registry.get<Position>(entity);
+            const Velocity&    velocity = registry.get<Velocity>(entity);
+            position.x += velocity.x;
+            position.z += velocity.z;
+        }
+        for (size_t i = 0; i < kEntityCount / 20; ++i)
+            registry.get<Health>(alive[rng() % alive.size()]).value -= 1;
+        for (size_t i = 0; i < kEntityCount / 100; ++i)
+        {
+            const size_t index = rng() % alive.size();
+            registry.destroy(alive[index]);
+            alive[index] = alive.back();
+            alive.pop_back();
+            spawn();
+        }
+    }
+};
+}  // namespace
+
+int main()
+{
+    World world;
+    for (size_t i = 0; i < kEntityCount; ++i)
+        world.spawn();
+
+    RegistrySnapshot<Position, Velocity, Health> snapshot;
+    RegistryDelta<Position, Velocity, Health>    encoder;
+    std::stringstream                            stream;
+    encoder.encode(world.registry, stream);
+
+    size_t snapshotBytes = 0, deltaBytes = 0;
+    double snapshotTime = 0., deltaTime = 0.;
+    for (size_t tick = 0; tick < kTickCount; ++tick)
+    {
+        world.tick();
+
+        std::stringstream full;
+        snapshotTime += moodycamel::microbench([&]() { snapshot.save(world.registry, full); }, 1, 1);
+        snapshotBytes += full.str().size();
+
+        std::stringstream delta;
+        deltaTime += moodycamel::microbench([&]() { encoder.encode(world.registry, delta); }, 1, 1);
+        deltaBytes += delta.str().size();
+    }
+
+    std::printf("%zu entities, %zu ticks: snapshot %.1f KB %.3f ms, delta %.1f KB %.3f ms per tick (x%.1f smaller)\n",
+                kEntityCount, kTickCount, snapshotBytes / 1024. / kTickCount, snapshotTime / kTickCount,
+                deltaBytes / 1024. / kTickCount, deltaTime / kTickCount, double(snapshotBytes) / deltaBytes);
+
+    return 0;
+}
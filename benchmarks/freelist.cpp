@@ -0,0 +1,92 @@
+#include "Hq/DynFreeList.h"
+#include "Hq/FreeList.h"
+#include "microbench/microbench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+using ParticleHandle = Handle<20, 12>;
+
+struct Particle
+{
+    float position[3];
+    float velocity[3];
+    float life;
+};
+
+constexpr size_t kAliveCount    = 50000;
+constexpr size_t kParticleCount = 50000;
+constexpr size_t kStorageSize   = 131072;
+
+using ParticleStorage = PackedFreeList<Particle, ParticleHandle, kStorageSize, true>;
+
+// One frame of a burst emitter: spawn a wave of particles next to the ones already alive, then the wave dies in
+// random order (particles have different life times)
+template <typename Storage, typename SpawnF, typename DespawnF>
+double benchFrame(Storage& storage, SpawnF spawn, DespawnF despawn)
+{
+    std::vector<ParticleHandle> alive(kAliveCount);
+    std::vector<ParticleHandle> wave(kParticleCount);
+    std::vector<ParticleHandle> dying(kParticleCount);
+    std::vector<size_t>         order(kParticleCount);
+    std::mt19937                rng(1234);
+
+    for (ParticleHandle& handle : alive)
+        handle = storage.alloc();
+
+    for (size_t i = 0; i < kParticleCount; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    return moodycamel::microbench(
+        [&]() {
+            spawn(storage, wave);
+            for (size_t i = 0; i < kParticleCount; ++i)
+                dying[i] = wave[order[i]];
+            despawn(storage, dying);
+        },
+        1, 50);
+}
+
+template <typename Storage>
+void benchStorage(const char* name, Storage& storage)
+{
+    const double single = benchFrame(
+        storage,
+        [](Storage& s, std::vector<ParticleHandle>& wave) {
+            for (ParticleHandle& handle : wave)
+                handle = s.alloc();
+        },
+        [](Storage& s, std::vector<ParticleHandle>& wave) {
+            for (const ParticleHandle& handle : wave)
+                s.remove(handle);
+        });
+
+    storage.clear();
+
+    const double batched = benchFrame(
+        storage, [](Storage& s, std::vector<ParticleHandle>& wave) { s.allocN(wave.data(), wave.size()); },
+        [](Storage& s, std::vector<ParticleHandle>& wave) { s.removeN(wave); });
+
+    std::printf("%s spawn/despawn %zu next to %zu: per item %.3f ms, batched %.3f ms (x%.2f)\n", name,
+                kParticleCount, kAliveCount, single, batched, single / batched);
+}
+}  // namespace
+
+int main()
+{
+    auto storage = std::make_unique<ParticleStorage>();
+    benchStorage("PackedFreeList", *storage);
+
+    DynPackedFreeList<Particle, ParticleHandle> dynamic(kAliveCount + kParticleCount);
+    benchStorage("DynPackedFreeList", dynamic);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "Hq/DynFreeList.h"
+#include "Hq/Handle.h"
+#include "microbench/microbench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct Transform
+{
+    float position[3];
+    float scale;
+};
+
+constexpr size_t kObjectCount = 500000;
+
+// Looks up every live object through its handle in random order, like systems following references between objects.
+// Half of the handles are stale so the generation check isn't always taken the same way.
+template <typename H>
+void benchHandle(const char* name)
+{
+    DynPackedFreeList<Transform, H> storage(kObjectCount);
+    std::vector<H>                  handles(kObjectCount);
+    std::mt19937                    rng(1234);
+
+    for (H& handle : handles)
+        handle = storage.alloc();
+    for (size_t i = 0; i < kObjectCount; i += 2)
+    {
+        storage.remove(handles[i]);
+        storage.alloc();
+    }
+    std::shuffle(handles.begin(), handles.end(), rng);
+
+    size_t valid     = 0;
+    double validTime = moodycamel::microbench(
+        [&]() {
+            for (const H& handle : handles)
+                valid += storage.isValid(handle);
+        },
+        1, 50);
+
+    float  sum     = 0.f;
+    double getTime = moodycamel::microbench(
+        [&]() {
+            for (const H& handle : handles)
+            {
+                if (const Transform* transform = storage.get(handle))
+                    sum += transform->scale;
+            }
+        },
+        1, 50);
+
+    std::printf("%s (%zu bytes) %zu lookups: isValid %.3f ms, get %.3f ms (%zu, %f)\n", name, sizeof(H), kObjectCount,
+                validTime, getTime, valid, sum);
+}
+}  // namespace
+
+int main()
+{
+    benchHandle<Handle<20, 12>>("Handle<20, 12>");
+    benchHandle<Handle64<32, 32>>("Handle64<32, 32>");
+    benchHandle<Handle64<24, 32, 8>>("Handle64<24, 32, 8>");
+
+    return 0;
+}
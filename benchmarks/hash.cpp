@@ -0,0 +1,78 @@
+#include "Hq/Hash.h"
+#include "microbench/microbench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+constexpr u32 kSide  = 1024;
+constexpr u32 kCount = kSide * kSide;
+
+// previous make_hash: std::hash per value combined with the boost formula
+size_t boostHash(u32 x, u32 y)
+{
+    size_t seed = std::hash<u32>()(x);
+    seed ^= std::hash<u32>()(y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+struct Vertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+// longest run of keys landing in the same bucket of a power of two table indexed by the low bits
+template <typename F>
+u32 maxBucketLoad(F hash)
+{
+    std::vector<u32> buckets(kCount, 0);
+    for (u32 i = 0; i < kCount; ++i)
+        ++buckets[hash(i % kSide, i / kSide) & (kCount - 1)];
+    return *std::max_element(buckets.begin(), buckets.end());
+}
+}  // namespace
+
+int main()
+{
+    size_t sum = 0;
+
+    const double boost = moodycamel::microbench(
+        [&]() {
+            for (u32 i = 0; i < kCount; ++i)
+                sum += boostHash(i % kSide, i / kSide);
+        },
+        1, 20);
+
+    const double mixed = moodycamel::microbench(
+        [&]() {
+            for (u32 i = 0; i < kCount; ++i)
+                sum += make_hash(i % kSide, i / kSide);
+        },
+        1, 20);
+
+    std::vector<Vertex> vertices(kCount / 16);
+    for (size_t i = 0; i < vertices.size(); ++i)
+        vertices[i] = {{float(i), 1.f, 2.f}, {0.f, 1.f, 0.f}, {0.5f, float(i)}};
+
+    const double bytes = moodycamel::microbench(
+        [&]() {
+            for (const Vertex& vertex : vertices)
+                sum += hash_bytes(vertex);
+        },
+        1, 20);
+
+    std::printf("%u grid keys: boost combine %.3f ms (max bucket %u), make_hash %.3f ms (max bucket %u)\n", kCount,
+                boost, maxBucketLoad([](u32 x, u32 y) { return boostHash(x, y); }), mixed,
+                maxBucketLoad([](u32 x, u32 y) { return make_hash(x, y); }));
+    std::printf("hash_bytes %zu vertices of %zu bytes: %.3f ms (%.2f GB/s) (%zu)\n", vertices.size(), sizeof(Vertex),
+                bytes, vertices.size() * sizeof(Vertex) / (bytes * 1e6), sum);
+
+    return 0;
+}
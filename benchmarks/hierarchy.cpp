@@ -0,0 +1,120 @@
+#include "Hq/Ecs/HierarchicalComponent.h"
+#include "microbench/microbench.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct SceneTag
+{
+};
+using SceneNode = HierarchicalComponent<SceneTag>;
+
+// the previous recursive pre-order visitor, for reference
+template <typename HierarchicalComp, typename VisitorF>
+void RecursiveDepthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+{
+    visitor(registry, entity);
+    const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
+    HierarchicalComp*       childComp = nullptr;
+    entt::entity            nextChild = component.firstChild;
+    if (nextChild != entt::null)
+    {
+        do
+        {
+            RecursiveDepthFirst<HierarchicalComp, VisitorF>(registry, nextChild, visitor);
+            childComp = registry.try_get<HierarchicalComp>(nextChild);
+        } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
+    }
+}
+
+template <typename HierarchicalComp, typename VisitorF>
+void RecursiveDepthFirstPost(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+{
+    const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
+    HierarchicalComp*       childComp = nullptr;
+    entt::entity            nextChild = component.firstChild;
+    if (nextChild != entt::null)
+    {
+        do
+        {
+            RecursiveDepthFirstPost<HierarchicalComp, VisitorF>(registry, nextChild, visitor);
+            childComp = registry.try_get<HierarchicalComp>(nextChild);
+        } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
+    }
+    visitor(registry, entity);
+}
+
+entt::entity addNode(entt::registry& registry, entt::entity parent, entt::entity previousSibling)
+{
+    const entt::entity entity = registry.create();
+    SceneNode&         node   = registry.emplace<SceneNode>(entity);
+    node.parent               = parent;
+    node.prevSibling          = previousSibling;
+    if (previousSibling != entt::null)
+        registry.get<SceneNode>(previousSibling).nextSibling = entity;
+    else if (parent != entt::null)
+        registry.get<SceneNode>(parent).firstChild = entity;
+    return entity;
+}
+
+// `depth` levels of `width` children under each node
+void addLevels(entt::registry& registry, entt::entity parent, u32 width, u32 depth)
+{
+    if (depth == 0)
+        return;
+    entt::entity previous = entt::null;
+    for (u32 i = 0; i < width; ++i)
+    {
+        previous = addNode(registry, parent, previous);
+        addLevels(registry, previous, width, depth - 1);
+    }
+}
+
+void bench(const char* name, entt::registry& registry, entt::entity root)
+{
+    u64            count   = 0;
+    auto           visitor = [&](entt::registry&, entt::entity entity) { count += entt::to_integral(entity); };
+    HierarchyStack stack;
+
+    const double recursive =
+        moodycamel::microbench([&]() { RecursiveDepthFirst<SceneNode>(registry, root, visitor); }, 1, 20);
+    const double iterative =
+        moodycamel::microbench([&]() { VisitHierarchyDepthFirst<SceneNode>(registry, root, visitor, stack); }, 1, 20);
+    const double recursivePost =
+        moodycamel::microbench([&]() { RecursiveDepthFirstPost<SceneNode>(registry, root, visitor); }, 1, 20);
+    const double iterativePost = moodycamel::microbench(
+        [&]() { VisitHierarchyDepthFirstPost<SceneNode>(registry, root, visitor, stack); }, 1, 20);
+
+    std::printf("%s: pre-order recursive %.3f ms, iterative %.3f ms (x%.2f), post-order recursive %.3f ms, iterative "
+                "%.3f ms (x%.2f) (%llu)\n",
+                name, recursive, iterative, recursive / iterative, recursivePost, iterativePost,
+                recursivePost / iterativePost, static_cast<unsigned long long>(count));
+}
+}  // namespace
+
+int main()
+{
+    {
+        // scene graph: 8 levels of 5 children, ~490k nodes
+        entt::registry     registry;
+        const entt::entity root = addNode(registry, entt::null, entt::null);
+        addLevels(registry, root, 5, 8);
+        bench("wide scene", registry, root);
+    }
+
+    {
+        // rope: a single chain, deep enough for the recursion but not too deep for the call stack
+        entt::registry registry;
+        entt::entity   root = addNode(registry, entt::null, entt::null);
+        entt::entity   last = root;
+        for (u32 i = 0; i < 20000; ++i)
+            last = addNode(registry, last, entt::null);
+        bench("chain", registry, root);
+    }
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "Hq/Math/Mat4x4.h"
+#include "Hq/Math/Math.h"
+#include "Hq/Math/Quat.h"
+#include "Hq/Math/Vec3.h"
+#include "Hq/Math/Vec4.h"
+#include "microbench/microbench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace hq;
+using namespace hq::math;
+
+namespace
+{
+constexpr size_t kCount = 4096;
+
+// the scalar code of Math.cpp, for reference, out of line like the library functions
+#if defined(_MSC_VER)
+#define HQ_NOINLINE __declspec(noinline)
+#else
+#define HQ_NOINLINE __attribute__((noinline))
+#endif
+
+HQ_NOINLINE void scalarMul(const Mat4x4& lhs, const Mat4x4& rhs, Mat4x4& dst)
+{
+    const float* m1 = lhs.data;
+    const float* m2 = rhs.data;
+    float*       d  = dst.data;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+            d[j * 4 + i] = m1[i] * m2[j * 4] + m1[4 + i] * m2[j * 4 + 1] + m1[8 + i] * m2[j * 4 + 2] +
+                           m1[12 + i] * m2[j * 4 + 3];
+    }
+}
+
+HQ_NOINLINE void scalarInvert(const Mat4x4& matrix, Mat4x4& dst)
+{
+    const float* m  = matrix.data;
+    float        a0 = m[0] * m[5] - m[1] * m[4];
+    float        a1 = m[0] * m[6] - m[2] * m[4];
+    float        a2 = m[0] * m[7] - m[3] * m[4];
+    float        a3 = m[1] * m[6] - m[2] * m[5];
+    float        a4 = m[1] * m[7] - m[3] * m[5];
+    float        a5 = m[2] * m[7] - m[3] * m[6];
+    float        b0 = m[8] * m[13] - m[9] * m[12];
+    float        b1 = m[8] * m[14] - m[10] * m[12];
+    float        b2 = m[8] * m[15] - m[11] * m[12];
+    float        b3 = m[9] * m[14] - m[10] * m[13];
+    float        b4 = m[9] * m[15] - m[11] * m[13];
+    float        b5 = m[10] * m[15] - m[11] * m[14];
+    float        det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
+    if (math::abs(det) <= kFloatTolerance)
+    {
+        std::printf("Determinant close to zero, can't invert matrix");
+        std::abort();
+    }
+
+    Mat4x4 inverse;
+    inverse.data[0]  = m[5] * b5 - m[6] * b4 + m[7] * b3;
+    inverse.data[1]  = -m[1] * b5 + m[2] * b4 - m[3] * b3;
+    inverse.data[2]  = m[13] * a5 - m[14] * a4 + m[15] * a3;
+    inverse.data[3]  = -m[9] * a5 + m[10] * a4 - m[11] * a3;
+    inverse.data[4]  = -m[4] * b5 + m[6] * b2 - m[7] * b1;
+    inverse.data[5]  = m[0] * b5 - m[2] * b2 + m[3] * b1;
+    inverse.data[6]  = -m[12] * a5 + m[14] * a2 - m[15] * a1;
+    inverse.data[7]  = m[8] * a5 - m[10] * a2 + m[11] * a1;
+    inverse.data[8]  = m[4] * b4 - m[5] * b2 + m[7] * b0;
+    inverse.data[9]  = -m[0] * b4 + m[1] * b2 - m[3] * b0;
+    inverse.data[10] = m[12] * a4 - m[13] * a2 + m[15] * a0;
+    inverse.data[11] = -m[8] * a4 + m[9] * a2 - m[11] * a0;
+    inverse.data[12] = -m[4] * b3 + m[5] * b1 - m[6] * b0;
+    inverse.data[13] = m[0] * b3 - m[1] * b1 + m[2] * b0;
+    inverse.data[14] = -m[12] * a3 + m[13] * a1 - m[14] * a0;
+    inverse.data[15] = m[8] * a3 - m[9] * a1 + m[10] * a0;
+
+    const float invDet = 1.0f / det;
+    for (int i = 0; i < 16; ++i)
+        dst.data[i] = inverse.data[i] * invDet;
+}
+
+HQ_NOINLINE void scalarMul(const Quat& q1, const Quat& q2, Quat& dst)
+{
+    float x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+    float y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+    float z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+    float w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+    dst.x   = x;
+    dst.y   = y;
+    dst.z   = z;
+    dst.w   = w;
+}
+
+HQ_NOINLINE void scalarTransform(const Vec4& vec, const Mat4x4& matrix, Vec4& dst)
+{
+    const float* v = vec.data;
+    const float* m = matrix.data;
+    float        x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + v[3] * m[12];
+    float        y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + v[3] * m[13];
+    float        z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + v[3] * m[14];
+    float        w = v[0] * m[3] + v[1] * m[7] + v[2] * m[11] + v[3] * m[15];
+    dst            = Vec4(x, y, z, w);
+}
+
+// the vector operators as they were before moving to the headers, a call per operation without LTO
+HQ_NOINLINE Vec3 outOfLineAdd(const Vec3& lhs, const Vec3& rhs)
+{
+    return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+HQ_NOINLINE Vec3 outOfLineMul(const Vec3& v, float f)
+{
+    return Vec3(f * v.x, f * v.y, f * v.z);
+}
+
+HQ_NOINLINE float outOfLineDot(const Vec3& v1, const Vec3& v2)
+{
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+HQ_NOINLINE float outOfLineLengthSquared(const Vec3& v)
+{
+    return (v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+void report(const char* name, double reference, double optimized, const char* referenceName = "scalar",
+            const char* optimizedName = "simd")
+{
+    std::printf("%s: %s %.3f us, %s %.3f us (x%.2f)\n", name, referenceName, reference * 1000.0, optimizedName,
+                optimized * 1000.0, reference / optimized);
+}
+}  // namespace
+
+int main()
+{
+    // rigid transforms with some scale, always invertible
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<Mat4x4>                   matrices(kCount), results(kCount);
+    std::vector<Quat>                     quats(kCount), quatResults(kCount);
+    std::vector<Vec4>                     vectors(kCount), vectorResults(kCount);
+    std::vector<Vec3>                     positions(kCount), velocities(kCount);
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        const Quat rotation = createFromEuler(dist(rng) * kPi, dist(rng) * kPi, dist(rng) * kPi);
+        matrices[i]         = Mat4x4(rotation, Vec3(1.5f + dist(rng), 1.5f + dist(rng), 1.5f + dist(rng)),
+                             Vec3(dist(rng) * 10.0f, dist(rng) * 10.0f, dist(rng) * 10.0f));
+        quats[i]            = rotation;
+        vectors[i]          = Vec4(dist(rng), dist(rng), dist(rng), 1.0f);
+        positions[i]        = Vec3(dist(rng), dist(rng), dist(rng));
+        velocities[i]       = Vec3(dist(rng), dist(rng), dist(rng));
+    }
+
+    const Mat4x4 parent = matrices[0];
+    const Quat   spin   = quats[0];
+
+    report("mul(Mat4x4, Mat4x4)",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   scalarMul(parent, matrices[i], results[i]);
+           }),
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   mul(parent, matrices[i], results[i]);
+           }));
+
+    report("mul(Mat4x4, Mat4x4*, count)",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   scalarMul(parent, matrices[i], results[i]);
+           }),
+           moodycamel::microbench([&]() { mul(parent, matrices.data(), results.data(), kCount); }));
+
+    report("invert(Mat4x4)",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   scalarInvert(matrices[i], results[i]);
+           }),
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   invert(matrices[i], results[i]);
+           }));
+
+    report("mul(Quat, Quat)",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   scalarMul(spin, quats[i], quatResults[i]);
+           }),
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   mul(spin, quats[i], quatResults[i]);
+           }));
+
+    report("transform(Vec4, Mat4x4)",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   scalarTransform(vectors[i], parent, vectorResults[i]);
+           }),
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+                   transform(vectors[i], parent, vectorResults[i]);
+           }));
+
+    // particle update: the trivial operators, out of line against inlined from the headers
+    const float dt     = 1.0f / 60.0f;
+    const Vec3  normal = normalize(Vec3(1.0f, 2.0f, 3.0f));
+    float       energy = 0.0f;
+    report("particles +, *, dot, lengthSquared",
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+               {
+                   positions[i] = outOfLineAdd(positions[i], outOfLineMul(velocities[i], dt));
+                   energy += outOfLineLengthSquared(velocities[i]) + outOfLineDot(positions[i], normal);
+               }
+           }),
+           moodycamel::microbench([&]() {
+               for (size_t i = 0; i < kCount; ++i)
+               {
+                   positions[i] = positions[i] + velocities[i] * dt;
+                   energy += lengthSquared(velocities[i]) + dot(positions[i], normal);
+               }
+           }),
+           "out of line", "inline");
+
+    float checksum = energy;
+    for (size_t i = 0; i < kCount; ++i)
+        checksum += results[i].data[0] + quatResults[i].x + vectorResults[i].x + positions[i].x;
+    std::printf("(%f)\n", checksum);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "Hq/StringHash.h"
+#include "microbench/microbench.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+constexpr size_t kPathCount = 200000;
+
+// asset paths like the ones hashed while loading a game, 30 to 90 characters
+std::vector<std::string> makePaths()
+{
+    const char* roots[]      = {"assets/characters", "assets/environments/forest", "assets/props", "assets/ui/hud"};
+    const char* kinds[]      = {"textures", "meshes", "materials", "animations/locomotion"};
+    const char* extensions[] = {".png", ".mesh", ".mat", ".anim"};
+
+    std::mt19937             rng(1234);
+    std::vector<std::string> paths;
+    paths.reserve(kPathCount);
+    for (size_t i = 0; i < kPathCount; ++i)
+    {
+        const u32 kind = rng() % 4;
+        paths.push_back(std::string(roots[rng() % 4]) + "/object_" + std::to_string(rng() % 5000) + "/" +
+                        kinds[kind] + "/variant_" + std::to_string(i) + extensions[kind]);
+    }
+    return paths;
+}
+}  // namespace
+
+int main()
+{
+    const std::vector<std::string>      paths = makePaths();
+    const std::vector<std::string_view> views(paths.begin(), paths.end());
+    std::vector<StringHash>             hashes(paths.size());
+
+    size_t totalLength = 0;
+    for (const std::string& path : paths)
+        totalLength += path.size();
+
+    u64          sum    = 0;
+    const double murmur = moodycamel::microbench(
+        [&]() {
+            for (const std::string& path : paths)
+                sum += MurmurHash3_32(path.data(), static_cast<uint>(path.size()), 0x12345678);
+        },
+        1, 20);
+
+    const double wyhash = moodycamel::microbench(
+        [&]() {
+            for (const std::string& path : paths)
+                sum += WyHash64(path.data(), path.size(), 0x12345678);
+        },
+        1, 20);
+
+    const double batched = moodycamel::microbench([&]() { hashMany(views, hashes.data()); }, 1, 20);
+
+    std::printf("%zu paths, %.1f characters on average\n", paths.size(), double(totalLength) / paths.size());
+    std::printf("MurmurHash3_32 %.3f ms, WyHash64 %.3f ms (x%.2f), hashMany (%u bit) %.3f ms (%llu)\n", murmur, wyhash,
+                murmur / wyhash, kStringHashBits, batched, static_cast<unsigned long long>(sum));
+
+    return 0;
+}
@@ -141,6 +141,65 @@ void deallocateArray(Allocator& allocator, T* array)
 }
 }  // allocator namespace
 
+/// std compatible allocator forwarding to one of our allocators, so std containers and FlatHashMap can live in an
+/// arena. The wrapped allocator must outlive the container and support deallocate.
+template <class T>
+class StdAllocatorAdapter
+{
+public:
+    using value_type = T;
+
+    template <class U>
+    struct rebind
+    {
+        using other = StdAllocatorAdapter<U>;
+    };
+
+    explicit StdAllocatorAdapter(Allocator& allocator)
+        : _allocator(&allocator)
+    {
+    }
+
+    template <class U>
+    StdAllocatorAdapter(const StdAllocatorAdapter<U>& other)
+        : _allocator(other.allocator())
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        void* p = _allocator->allocate(count * sizeof(T), static_cast<u8>(alignof(T)));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        _allocator->deallocate(p);
+    }
+
+    Allocator* allocator() const
+    {
+        return _allocator;
+    }
+
+    template <class U>
+    bool operator==(const StdAllocatorAdapter<U>& other) const
+    {
+        return _allocator == other.allocator();
+    }
+
+    template <class U>
+    bool operator!=(const StdAllocatorAdapter<U>& other) const
+    {
+        return _allocator != other.allocator();
+    }
+
+private:
+    Allocator* _allocator;
+};
+
 // Inline functions definitions
 
 namespace pointer_math
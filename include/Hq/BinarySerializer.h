@@ -2,6 +2,7 @@
 
 #include "Hq/BasicTypes.h"
 
+#include <cassert>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -117,6 +118,12 @@ struct BinarySerializer
     void operator()(entt::entity& value);
     void operator()(const entt::entity& value);
 
+    /// Writes `size` raw bytes, for blocks of trivially copyable data
+    void write(const void* data, size_t size)
+    {
+        m_out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
 private:
     std::ostream& m_out;
 };
@@ -208,6 +215,13 @@ struct BinaryDeserializer
     void operator()(double& value);
     void operator()(entt::entity& value);
 
+    /// Reads `size` raw bytes written by BinarySerializer::write, returns false if the stream ended before
+    bool read(void* data, size_t size)
+    {
+        m_in.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        return static_cast<bool>(m_in);
+    }
+
 private:
     std::istream& m_in;
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace hq
+{
+/// Index of the lowest set bit, value must not be 0
+inline u32 countTrailingZeros(u64 value)
+{
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+}  // namespace hq
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/FreeList.h"
+#include "Hq/Handle.h"
+
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace hq
+{
+/// Unbounded version of PackedFreeList that grows by whole blocks of BlockSize elements.
+/// Blocks are allocated on demand and never move, so object addresses stay stable when the list grows.
+/// Each block keeps its own packed array: removing an object swaps it with the last object of the same block,
+/// only objects from that block can move (same guarantee as PackedFreeList).
+/// Handle index is `block * BlockSize + slot`, lookup goes through the block table in O(1).
+/// @example usage:
+///     typedef ChunkedPackedFreeList<Particle, ParticleHandle, 4096, true> ParticleStorage;
+///     ParticleStorage storage;
+///     ParticleHandle handle = storage.alloc();
+///     Particle* particle = storage.get(handle);
+///     for (u32 block = 0; block < storage.blockCount(); ++block)
+///         for (u32 i = 0; i < storage.blockSize(block); ++i)
+///             update(storage.blockData(block)[i]);
+/// @tparam T value to store
+/// @tparam H type of the handle of the stored type
+/// @tparam BlockSize number of elements per block, must be a power of two
+/// @tparam IsPOD bool specifying if the stored type is POD
+template <typename T, typename H, size_t BlockSize, bool IsPOD>
+class ChunkedPackedFreeList
+{
+    static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
+    struct Block
+    {
+        Block()
+            : count(0)
+            , freeHead(0)
+        {
+            for (u32 i = 0; i < BlockSize; ++i)
+            {
+                slots[i].setIndex(i + 1);
+                slots[i].setGeneration(1);
+            }
+        }
+
+        // slots are addressed by handles, for live objects they hold the packed location inside the block
+        // and for free ones the next free slot
+        H   slots[BlockSize];
+        u32 indices[BlockSize];
+        u32 count;
+        u32 freeHead;
+        // allocated separately so empty blocks can give their storage back while keeping generations
+        std::unique_ptr<T[]> array;
+    };
+
+public:
+    static const size_t kBlockSize = BlockSize;
+
+    ChunkedPackedFreeList() = default;
+
+    ChunkedPackedFreeList(const ChunkedPackedFreeList&) = delete;
+    ChunkedPackedFreeList& operator=(const ChunkedPackedFreeList&) = delete;
+
+    void clear()
+    {
+        _freeBlocks.clear();
+        for (u32 blockIndex = static_cast<u32>(_blocks.size()); blockIndex-- > 0;)
+        {
+            Block& block = *_blocks[blockIndex];
+            for (u32 i = 0; i < block.count; ++i)
+            {
+                FreelistConstructor<T, IsPOD>::destruct(&block.array[i]);
+                FreelistConstructor<T, IsPOD>::construct(&block.array[i]);
+                releaseSlot(block, block.indices[i]);
+            }
+            block.count = 0;
+            _freeBlocks.push_back(blockIndex);
+        }
+        _count = 0;
+    }
+
+    bool isValid(const H& handle) const
+    {
+        const size_t blockIndex = handle.index() / BlockSize;
+        return ((blockIndex < _blocks.size()) && (handle.generation() != 0) &&
+                (_blocks[blockIndex]->slots[handle.index() & (BlockSize - 1)].generation() == handle.generation()));
+    }
+
+    H alloc()
+    {
+        if (_freeBlocks.empty())
+            addBlock();
+
+        const u32 blockIndex = _freeBlocks.back();
+        Block&    block      = *_blocks[blockIndex];
+
+        if (!block.array)
+            block.array.reset(new T[BlockSize]);
+
+        const u32 slot = block.freeHead;
+        block.freeHead = block.slots[slot].index();
+        // storage location is first element beyond last in this block
+        block.slots[slot].setIndex(block.count);
+        block.indices[block.count] = slot;
+        block.count++;
+        _count++;
+
+        if (block.count == BlockSize)
+            _freeBlocks.pop_back();
+
+        H handle(blockIndex * static_cast<u32>(BlockSize) + slot, block.slots[slot].generation());
+        return handle;
+    }
+
+    void remove(const H& handle)
+    {
+        if (!isValid(handle))
+            return;
+
+        const u32 blockIndex = handle.index() / BlockSize;
+        const u32 slot       = handle.index() & (BlockSize - 1);
+        Block&    block      = *_blocks[blockIndex];
+
+        const u32 releasedIndex = block.slots[slot].index();
+        const u32 lastIndex     = block.count - 1;
+        // "swap" the released item with the last one of the block to preserve packing
+        std::swap(block.array[releasedIndex], block.array[lastIndex]);
+        block.indices[releasedIndex] = block.indices[lastIndex];
+        block.slots[block.indices[releasedIndex]].setIndex(releasedIndex);
+
+        // reconstruct object, so it's clean the next time we use it
+        FreelistConstructor<T, IsPOD>::destruct(&block.array[lastIndex]);
+        FreelistConstructor<T, IsPOD>::construct(&block.array[lastIndex]);
+
+        releaseSlot(block, slot);
+        block.count--;
+        _count--;
+
+        // block just went from full to not full, make it available for allocations again
+        if (block.count == BlockSize - 1)
+            _freeBlocks.push_back(blockIndex);
+    }
+
+    T* get(const H& handle)
+    {
+        return const_cast<T*>(static_cast<const ChunkedPackedFreeList*>(this)->get(handle));
+    }
+
+    const T* get(const H& handle) const
+    {
+        if (isValid(handle))
+        {
+            const Block& block = *_blocks[handle.index() / BlockSize];
+            return &block.array[block.slots[handle.index() & (BlockSize - 1)].index()];
+        }
+
+        return nullptr;
+    }
+
+    T& getRef(const H& handle)
+    {
+        return const_cast<T&>(static_cast<const ChunkedPackedFreeList*>(this)->getRef(handle));
+    }
+
+    const T& getRef(const H& handle) const
+    {
+        assert(isValid(handle));
+        const Block& block = *_blocks[handle.index() / BlockSize];
+        return block.array[block.slots[handle.index() & (BlockSize - 1)].index()];
+    }
+
+    /// Calls `func(T&)` for every packed object, block by block
+    template <typename F>
+    void forEach(F&& func)
+    {
+        for (auto& block : _blocks)
+        {
+            for (u32 i = 0; i < block->count; ++i)
+                func(block->array[i]);
+        }
+    }
+
+    /// Gives back the storage of blocks that have no live objects. Generations are kept so old handles stay invalid.
+    void shrinkToFit()
+    {
+        for (auto& block : _blocks)
+        {
+            if (block->count == 0)
+                block->array.reset();
+        }
+    }
+
+    /// Total number of live objects
+    size_t size() const
+    {
+        return _count;
+    }
+
+    u32 blockCount() const
+    {
+        return static_cast<u32>(_blocks.size());
+    }
+
+    /// Number of packed objects in a block, iterate blockData(block)[0, blockSize(block))
+    u32 blockSize(u32 block) const
+    {
+        assert(block < _blocks.size());
+        return _blocks[block]->count;
+    }
+
+    T* blockData(u32 block)
+    {
+        assert(block < _blocks.size());
+        return _blocks[block]->array.get();
+    }
+
+    const T* blockData(u32 block) const
+    {
+        assert(block < _blocks.size());
+        return _blocks[block]->array.get();
+    }
+
+    H getHandleFromPackedIndex(u32 block, u32 index) const
+    {
+        assert(block < _blocks.size() && index < _blocks[block]->count);
+        const u32 slot = _blocks[block]->indices[index];
+        H         handle(block * static_cast<u32>(BlockSize) + slot, _blocks[block]->slots[slot].generation());
+        return handle;
+    }
+
+private:
+    void addBlock()
+    {
+        _freeBlocks.push_back(static_cast<u32>(_blocks.size()));
+        _blocks.emplace_back(new Block());
+    }
+
+    static void releaseSlot(Block& block, u32 slot)
+    {
+        // increment the generation
+        block.slots[slot].setGeneration(block.slots[slot].generation() + 1);
+        if (block.slots[slot].generation() == 0)
+            block.slots[slot].setGeneration(1);
+
+        block.slots[slot].setIndex(block.freeHead);
+        block.freeHead = slot;
+    }
+
+private:
+    size_t                              _count {0};
+    std::vector<std::unique_ptr<Block>> _blocks;
+    // blocks with at least one free slot, allocation always happens in the last one
+    std::vector<u32>                    _freeBlocks;
+};
+}  // namespace hq
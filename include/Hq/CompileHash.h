@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+
+namespace hq
+{
+/// constexpr versions of the runtime string hashes (MurmurHash3_32, WyHash64), same results for the same input.
+/// Used by the `_sh` literal, prefer the runtime functions for strings only known at runtime.
+namespace compile
+{
+    // little endian read of n bytes, like the unaligned loads of the runtime versions on our platforms
+    constexpr u64 read(const char* p, size_t n)
+    {
+        u64 v = 0;
+        for (size_t i = 0; i < n; ++i)
+            v |= u64(static_cast<u8>(p[i])) << (8 * i);
+        return v;
+    }
+
+    constexpr u32 rotl32(u32 x, u32 r)
+    {
+        return (x << r) | (x >> (32 - r));
+    }
+
+    constexpr u32 murmur3_32(const char* str, size_t len, u32 seed)
+    {
+        const u32 c1 = 0xcc9e2d51;
+        const u32 c2 = 0x1b873593;
+        u32       h1 = seed;
+
+        const size_t nblocks = len / 4;
+        for (size_t i = 0; i < nblocks; ++i)
+        {
+            u32 k1 = static_cast<u32>(read(str + i * 4, 4));
+            k1 *= c1;
+            k1 = rotl32(k1, 15);
+            k1 *= c2;
+
+            h1 ^= k1;
+            h1 = rotl32(h1, 13);
+            h1 = h1 * 5 + 0xe6546b64;
+        }
+
+        if (len & 3)
+        {
+            u32 k1 = static_cast<u32>(read(str + nblocks * 4, len & 3));
+            k1 *= c1;
+            k1 = rotl32(k1, 15);
+            k1 *= c2;
+            h1 ^= k1;
+        }
+
+        h1 ^= static_cast<u32>(len);
+        h1 ^= h1 >> 16;
+        h1 *= 0x85ebca6b;
+        h1 ^= h1 >> 13;
+        h1 *= 0xc2b2ae35;
+        h1 ^= h1 >> 16;
+        return h1;
+    }
+
+    // 64x64 -> 128 bits multiply in 32 bit halves, low half in a and high half in b
+    constexpr void wymum(u64& a, u64& b)
+    {
+        const u64 ha = a >> 32, hb = b >> 32, la = static_cast<u32>(a), lb = static_cast<u32>(b);
+        const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        const u64 t  = rl + (rm0 << 32);
+        const u64 lo = t + (rm1 << 32);
+        a            = lo;
+        b            = rh + (rm0 >> 32) + (rm1 >> 32) + u64(t < rl) + u64(lo < t);
+    }
+
+    constexpr u64 wymix(u64 a, u64 b)
+    {
+        wymum(a, b);
+        return a ^ b;
+    }
+
+    constexpr u64 wyhash64(const char* str, size_t len, u64 seed)
+    {
+        const u64 s0 = 0xa0761d6478bd642full, s1 = 0xe7037ed1a0b428dbull, s2 = 0x8ebc6af09c88c6e3ull,
+                  s3 = 0x589965cc75374cc3ull;
+
+        const char* p = str;
+        seed ^= wymix(seed ^ s0, s1);
+        u64 a = 0, b = 0;
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                a = (read(p, 4) << 32) | read(p + ((len >> 3) << 2), 4);
+                b = (read(p + len - 4, 4) << 32) | read(p + len - 4 - ((len >> 3) << 2), 4);
+            }
+            else if (len > 0)
+                a = (u64(static_cast<u8>(p[0])) << 16) | (u64(static_cast<u8>(p[len >> 1])) << 8) |
+                    static_cast<u8>(p[len - 1]);
+        }
+        else
+        {
+            size_t i = len;
+            if (i > 48)
+            {
+                u64 see1 = seed, see2 = seed;
+                do
+                {
+                    seed = wymix(read(p, 8) ^ s1, read(p + 8, 8) ^ seed);
+                    see1 = wymix(read(p + 16, 8) ^ s2, read(p + 24, 8) ^ see1);
+                    see2 = wymix(read(p + 32, 8) ^ s3, read(p + 40, 8) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = wymix(read(p, 8) ^ s1, read(p + 8, 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = read(p + i - 16, 8);
+            b = read(p + i - 8, 8);
+        }
+
+        a ^= s1;
+        b ^= seed;
+        wymum(a, b);
+        return wymix(a ^ s0 ^ len, b ^ s1);
+    }
+}  // namespace compile
+}  // namespace hq
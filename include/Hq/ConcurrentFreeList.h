@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/FreeList.h"
+#include "Hq/Handle.h"
+#include "Hq/SpinLock.h"
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+namespace hq
+{
+/// FreeList that can allocate and remove handles from several threads at the same time (e.g. JobManager jobs).
+/// Free indices live in a lock-free global stack, each thread takes and returns them through a small cache so most
+/// operations don't touch shared state. When the global stack runs dry, indices are stolen from the other caches,
+/// so allocation only fails when every index is in use. Generations are bumped atomically on removal, `isValid` and
+/// `get` can be called concurrently with `remove`, a removed handle is reported invalid as soon as `remove` returns.
+/// @note Access to the objects themselves is not synchronized, don't remove an object another thread is using.
+/// @tparam T value to store
+/// @tparam H type of the handle of the stored type
+/// @tparam StorageSize maximum size of the values to store
+/// @tparam IsPOD bool specifying if the stored type is POD
+template <typename T, typename H, size_t StorageSize, bool IsPOD>
+class ConcurrentFreeList
+{
+public:
+    static const size_t kStorageSize = StorageSize;
+    // threads are spread over this many caches, threads sharing a cache take turns through its spinlock
+    static const u32 kThreadCaches = 16;
+    static const u32 kCacheSize    = 64;
+    // number of indices moved between a thread cache and the global stack at once
+    static const u32 kCacheBatch = kCacheSize / 2;
+
+    ConcurrentFreeList()
+        : _generations(new std::atomic<u32>[StorageSize])
+        , _next(new std::atomic<u32>[StorageSize])
+        , _storage(new T[StorageSize])
+    {
+        // global stack initially holds every index in order
+        for (u32 i = 0; i < StorageSize; ++i)
+        {
+            _generations[i].store(1, std::memory_order_relaxed);
+            _next[i].store(i + 1 < StorageSize ? i + 1 : kEnd, std::memory_order_relaxed);
+        }
+        _head.store(StorageSize > 0 ? 0 : kEnd, std::memory_order_release);
+    }
+
+    ConcurrentFreeList(const ConcurrentFreeList&) = delete;
+    ConcurrentFreeList& operator=(const ConcurrentFreeList&) = delete;
+
+    bool isValid(const H& handle) const
+    {
+        return (handle.index() < StorageSize) && (handle.generation() != 0) &&
+               (_generations[handle.index()].load(std::memory_order_acquire) == handle.generation());
+    }
+
+    H alloc()
+    {
+        ThreadCache& cache = threadCache();
+        cache.lock.lock();
+
+        if (cache.count == 0)
+        {
+            while (cache.count < kCacheBatch)
+            {
+                const u32 index = pop();
+                if (index == kEnd)
+                    break;
+                cache.indices[cache.count++] = index;
+            }
+        }
+
+        u32 index = kEnd;
+        if (cache.count > 0)
+            index = cache.indices[--cache.count];
+        cache.lock.unlock();
+
+        // global stack is empty but other caches may still hold free indices
+        if (index == kEnd)
+            index = steal();
+
+        if (index == kEnd)
+            return H::invalid;
+
+        H handle(index, _generations[index].load(std::memory_order_acquire));
+        return handle;
+    }
+
+    void remove(const H& handle)
+    {
+        if (handle.index() >= StorageSize || handle.generation() == 0)
+            return;
+
+        // only one of several concurrent removals of the same handle wins the generation bump
+        u32 generation = handle.generation();
+        if (!_generations[handle.index()].compare_exchange_strong(generation, nextGeneration(generation),
+                                                                  std::memory_order_acq_rel))
+            return;
+
+        FreelistConstructor<T, IsPOD>::destruct(&_storage[handle.index()]);
+        FreelistConstructor<T, IsPOD>::construct(&_storage[handle.index()]);
+
+        ThreadCache& cache = threadCache();
+        cache.lock.lock();
+
+        if (cache.count == kCacheSize)
+        {
+            // give half of the cache back so other threads can allocate it
+            cache.count -= kCacheBatch;
+            pushChain(&cache.indices[cache.count], kCacheBatch);
+        }
+
+        cache.indices[cache.count++] = handle.index();
+        cache.lock.unlock();
+    }
+
+    T* get(const H& handle)
+    {
+        return isValid(handle) ? &_storage[handle.index()] : nullptr;
+    }
+
+    const T* get(const H& handle) const
+    {
+        return isValid(handle) ? &_storage[handle.index()] : nullptr;
+    }
+
+    T& getRef(const H& handle)
+    {
+        assert(isValid(handle));
+        return _storage[handle.index()];
+    }
+
+    const T& getRef(const H& handle) const
+    {
+        assert(isValid(handle));
+        return _storage[handle.index()];
+    }
+
+private:
+    static const u32 kEnd = 0xffffffffu;
+
+    struct alignas(64) ThreadCache
+    {
+        SpinLock lock;
+        u32      count {0};
+        u32      indices[kCacheSize];
+    };
+
+    static u32 nextGeneration(u32 generation)
+    {
+        // let the handle type do the wrap-around of its generation bits, 0 is reserved for invalid handles
+        H handle;
+        handle.setGeneration(generation + 1);
+        return handle.generation() != 0 ? handle.generation() : 1;
+    }
+
+    ThreadCache& threadCache()
+    {
+        static std::atomic<u32> threadCounter {0};
+        thread_local const u32  slot = threadCounter.fetch_add(1, std::memory_order_relaxed) % kThreadCaches;
+        return _caches[slot];
+    }
+
+    u32 steal()
+    {
+        for (ThreadCache& cache : _caches)
+        {
+            cache.lock.lock();
+            if (cache.count > 0)
+            {
+                // keep one and hand the rest of the stolen half to the global stack for the next allocations
+                const u32 stolen = (cache.count + 1) / 2;
+                cache.count -= stolen;
+                const u32 index = cache.indices[cache.count];
+                if (stolen > 1)
+                    pushChain(&cache.indices[cache.count + 1], stolen - 1);
+                cache.lock.unlock();
+                return index;
+            }
+            cache.lock.unlock();
+        }
+        return kEnd;
+    }
+
+    // Treiber stack, the top 32 bits of the head are a tag incremented on every change to avoid ABA problems
+    u32 pop()
+    {
+        u64 head = _head.load(std::memory_order_acquire);
+        while (static_cast<u32>(head) != kEnd)
+        {
+            const u32 index = static_cast<u32>(head);
+            const u64 next  = ((head >> 32) + 1) << 32 | _next[index].load(std::memory_order_relaxed);
+            if (_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+                return index;
+        }
+        return kEnd;
+    }
+
+    void pushChain(const u32* indices, u32 count)
+    {
+        for (u32 i = 0; i + 1 < count; ++i)
+            _next[indices[i]].store(indices[i + 1], std::memory_order_relaxed);
+
+        const u32 last = indices[count - 1];
+        u64       head = _head.load(std::memory_order_relaxed);
+        u64       newHead;
+        do
+        {
+            _next[last].store(static_cast<u32>(head), std::memory_order_relaxed);
+            newHead = ((head >> 32) + 1) << 32 | indices[0];
+        } while (!_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    std::unique_ptr<std::atomic<u32>[]> _generations;
+    // links of the global free stack
+    std::unique_ptr<std::atomic<u32>[]> _next;
+    std::unique_ptr<T[]>                _storage;
+    std::atomic<u64>                    _head {0};
+    ThreadCache                         _caches[kThreadCaches];
+};
+}  // namespace hq
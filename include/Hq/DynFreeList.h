@@ -1,48 +1,71 @@
 #pragma once
 
 #include "Hq/BasicTypes.h"
+#include "Hq/FreeList.h"
 #include "Hq/Handle.h"
+#include "Hq/JobManager.h"
+#include "Hq/Span.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <utility>
 #include <vector>
 
 namespace hq
 {
+/// Growable version of FreeList, storage is extended by one element when the free list is exhausted.
+/// @note Growth may reallocate the storage, pointers returned by `get` are invalidated by `alloc`.
+/// Handles stay valid across growth.
+/// @tparam T value to store, must be default constructible and move assignable
+/// @tparam H type of the handle of the stored type
 template <typename T, typename H>
 class DynFreeList
 {
 public:
-    explicit DynFreeList(size_t capacity)
-        : _capacity(capacity)
+    explicit DynFreeList(size_t capacity = 0)
     {
-        init();
+        reserve(capacity);
     }
 
+    /// Removes all objects and resets the free list, all handles given before are no longer valid
     void clear()
     {
         _freeList.clear();
         _storage.clear();
-        init();
+        _freeHead = 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        _freeList.reserve(capacity);
+        _storage.reserve(capacity);
+    }
+
+    /// Releases unused capacity, slots are never given back since they keep the generations
+    void shrink_to_fit()
+    {
+        _freeList.shrink_to_fit();
+        _storage.shrink_to_fit();
     }
 
     bool isValid(const H& handle) const
     {
-        return ((handle.index() < _storage.size()) && (handle.generation() != 0) &&
+        return ((handle.index() < _freeList.size()) && (handle.generation() != 0) &&
                 (_freeList[handle.index()].generation() == handle.generation()));
     }
 
     H alloc()
     {
-        // Don't assert anymore, let higher level code handle allocation failure
-        if (_freeHead >= _storage.size())
+        if (_freeHead >= _freeList.size())
         {
+            // free list exhausted, append a new slot that points past the end like the last slot of FreeList
             _storage.emplace_back();
-            _freeList.emplace_back();
-            H handle = _freeList.back();
-            handle.setIndex(_storage.size());
-            handle.setGeneration(1);
+            _freeList.emplace_back(static_cast<u32>(_freeList.size() + 1), 1);
         }
 
         u32 index = _freeHead;
-        _freeHead      = _freeList[index].index();
+        _freeHead = _freeList[index].index();
         H handle(index, _freeList[index].generation());
         return handle;
     }
@@ -52,6 +75,9 @@ public:
         if (!isValid(handle))
             return;
 
+        // reset object, so it's clean the next time we use it
+        _storage[handle.index()] = T();
+
         _freeList[handle.index()].setGeneration(_freeList[handle.index()].generation() + 1);
 
         if (_freeList[handle.index()].generation() == 0)
@@ -61,6 +87,19 @@ public:
         _freeHead = handle.index();
     }
 
+    /// Allocates `count` handles in one go
+    void allocN(H* outHandles, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            outHandles[i] = alloc();
+    }
+
+    void removeN(Span<const H> handles)
+    {
+        for (const H& handle : handles)
+            remove(handle);
+    }
+
     T* get(const H& handle)
     {
         return const_cast<T*>(static_cast<const DynFreeList*>(this)->get(handle));
@@ -83,19 +122,16 @@ public:
     }
 
 private:
-    void init()
-    {
-        _freeList.reserve(_capacity);
-        _storage.reserve(_capacity);
-    }
-
-private:
-    size_t         _capacity {0};
-    u32       _freeHead {0};
+    u32            _freeHead {0};
     std::vector<H> _freeList;
     std::vector<T> _storage;
 };
 
+/// Growable version of PackedFreeList, the packed array holds exactly the live objects.
+/// @note Growth may reallocate the packed storage, pointers returned by `get` are invalidated by `alloc`
+/// and `remove`. Handles stay valid across growth.
+/// @tparam T value to store, must be default constructible and move assignable
+/// @tparam H type of the handle of the stored type
 template <typename T, typename H>
 class DynPackedFreeList
 {
@@ -104,51 +140,66 @@ class DynPackedFreeList
         // to remove an object with this solution we use the standard trick of swapping it
         // with the last item in the array. Then we update the index so that it points to
         // the new location of the swapped object.
-        std::vector<size_t> indices;
-        std::vector<T>      array;
+        std::vector<u32> indices;
+        std::vector<T>   array;
     };
 
 public:
-    DynPackedFreeList(size_t capacity)
-        : _capacity(capacity)
+    explicit DynPackedFreeList(size_t capacity = 0)
     {
-        init();
+        reserve(capacity);
     }
 
+    /// Removes all objects and resets the free list, all handles given before are no longer valid
     void clear()
     {
         _freeList.clear();
         _storage.indices.clear();
         _storage.array.clear();
-        init();
+        _freeHead = 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        _freeList.reserve(capacity);
+        _storage.indices.reserve(capacity);
+        _storage.array.reserve(capacity);
+    }
+
+    /// Releases unused capacity of the packed storage, slots are never given back since they keep the generations
+    void shrink_to_fit()
+    {
+        _freeList.shrink_to_fit();
+        _storage.indices.shrink_to_fit();
+        _storage.array.shrink_to_fit();
+    }
+
+    size_t size() const
+    {
+        return _storage.array.size();
     }
 
     bool isValid(const H& handle) const
     {
-        return ((handle.index() < _storage.array.size()) && (handle.generation() != 0) &&
+        return ((handle.index() < _freeList.size()) && (handle.generation() != 0) &&
                 (_freeList[handle.index()].generation() == handle.generation()));
     }
 
     H alloc()
     {
-        // Don't assert anymore, let higher level code handle allocation failure
-        if (_freeHead >= _storage.array.size())
+        if (_freeHead >= _freeList.size())
         {
-            _storage.indices.emplace_back();
-            _storage.array.emplace_back();
-            _freeList.emplace_back();
-            H handle = _freeList.back();
-            handle.setIndex(_storage.indices.size());
-            handle.setGeneration(1);
+            // free list exhausted, append a new slot that points past the end
+            _freeList.emplace_back(static_cast<u32>(_freeList.size() + 1), 1);
         }
 
         const u32 freeIndex = _freeHead;
-        _freeHead                = _freeList[freeIndex].index();
+        _freeHead           = _freeList[freeIndex].index();
         // storage location is first element beyond last
-        _freeList[freeIndex].setIndex(_storage.array.size());
-        const u32 storageLocation = _freeList[freeIndex].index();
+        _freeList[freeIndex].setIndex(static_cast<u32>(_storage.array.size()));
         // point back to freelist element
-        _storage.indices[storageLocation] = freeIndex;
+        _storage.indices.push_back(freeIndex);
+        _storage.array.emplace_back();
 
         H handle(freeIndex, _freeList[freeIndex].generation());
         return handle;
@@ -156,7 +207,7 @@ public:
 
     void remove(const H& handle)
     {
-        if (!isValid(handle) || _storage.array.size() == 0)
+        if (!isValid(handle) || _storage.array.empty())
             return;
 
         // increment the generation
@@ -164,16 +215,20 @@ public:
         if (_freeList[handle.index()].generation() == 0)
             _freeList[handle.index()].setGeneration(1);
 
-        u32 releasedIndex = _freeList[handle.index()].index();
-        u32 lastIndex     = _storage.count - 1;
-        // "swap" the released item with the last one to preserve packing
-        std::swap(_storage.array[releasedIndex], _storage.array[lastIndex]);
-        // swap indices to freelist handle too
-        _storage.indices[releasedIndex] = _storage.indices[lastIndex];
-        // make freelist for swapped element point to the new location
-        _freeList[_storage.indices[lastIndex]].setIndex(releasedIndex);
+        const u32 releasedIndex = _freeList[handle.index()].index();
+        const u32 lastIndex     = static_cast<u32>(_storage.array.size() - 1);
+        if (releasedIndex != lastIndex)
+        {
+            // move the last item in the released place to preserve packing
+            _storage.array[releasedIndex] = std::move(_storage.array[lastIndex]);
+            // swap indices to freelist handle too
+            _storage.indices[releasedIndex] = _storage.indices[lastIndex];
+            // make freelist for swapped element point to the new location
+            _freeList[_storage.indices[releasedIndex]].setIndex(releasedIndex);
+        }
 
-        _storage.array.erase(_storage.array.back());
+        _storage.array.pop_back();
+        _storage.indices.pop_back();
 
         // set the release freelist index point to the next free one
         _freeList[handle.index()].setIndex(_freeHead);
@@ -181,6 +236,78 @@ public:
         _freeHead = handle.index();
     }
 
+    /// Allocates `count` handles in one go, new objects are appended at the end of the packed array in handle order
+    void allocN(H* outHandles, size_t count)
+    {
+        const size_t first = _storage.array.size();
+        _storage.indices.resize(first + count);
+        _storage.array.resize(first + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (_freeHead >= _freeList.size())
+                _freeList.emplace_back(static_cast<u32>(_freeList.size() + 1), 1);
+
+            const u32 freeIndex = _freeHead;
+            _freeHead           = _freeList[freeIndex].index();
+            _freeList[freeIndex].setIndex(static_cast<u32>(first + i));
+            _storage.indices[first + i] = freeIndex;
+            outHandles[i]               = H(freeIndex, _freeList[freeIndex].generation());
+        }
+    }
+
+    /// Removes a batch of handles, invalid and duplicated handles are ignored.
+    /// Released objects are compacted in one pass (see detail::compactPackedStorage).
+    void removeN(Span<const H> handles)
+    {
+        _releasedIndices.clear();
+
+        for (const H& handle : handles)
+        {
+            if (!isValid(handle))
+                continue;
+
+            _releasedIndices.push_back(_freeList[handle.index()].index());
+
+            _freeList[handle.index()].setGeneration(_freeList[handle.index()].generation() + 1);
+            if (_freeList[handle.index()].generation() == 0)
+                _freeList[handle.index()].setGeneration(1);
+
+            _freeList[handle.index()].setIndex(_freeHead);
+            _freeHead = handle.index();
+        }
+
+        const u32 newCount = detail::compactPackedStorage(_storage.array.data(), _storage.indices.data(),
+                                                          _freeList.data(), static_cast<u32>(_storage.array.size()),
+                                                          _releasedIndices, _releasedMarks);
+
+        _storage.array.resize(newCount);
+        _storage.indices.resize(newCount);
+    }
+
+    /// Calls `func(T&)` for every packed object
+    template <typename F>
+    void forEach(F&& func)
+    {
+        for (T& object : _storage.array)
+            func(object);
+    }
+
+    /// Calls `func(T&)` for every packed object from the job manager workers, returns when all objects are processed.
+    /// `func` must be safe to call concurrently for different objects.
+    template <typename F>
+    void forEachParallel(JobManager& jobManager, F&& func)
+    {
+        jobManager.parallel_for<T, CountSplitter<T, kFreeListParallelBatchSize>>(
+            [&func](void* data, size_t count) {
+                T* objects = static_cast<T*>(data);
+                for (size_t i = 0; i < count; ++i)
+                    func(objects[i]);
+            },
+            _storage.array.data(), _storage.array.size());
+        jobManager.wait();
+    }
+
     T* get(const H& handle)
     {
         return const_cast<T*>(static_cast<const DynPackedFreeList*>(this)->get(handle));
@@ -218,28 +345,28 @@ public:
 
     H getHandleFromPackedIndex(size_t index) const
     {
-        assert(index < _storage.count);
+        assert(index < _storage.array.size());
         H handle(_storage.indices[index], _freeList[_storage.indices[index]].generation());
         return handle;
     }
 
+    // chache friendly, iterate over it
     const std::vector<T>& packedStorage() const
     {
         return _storage.array;
     }
 
-private:
-    void init()
+    std::vector<T>& packedStorage()
     {
-        _freeList.reserve(_capacity);
-        _storage.indices.reserve(_capacity);
-        _storage.array.reserve(_capacity);
+        return _storage.array;
     }
 
 private:
-    size_t         _capacity {0};
-    size_t         _freeHead {0};
-    std::vector<H> _freeList;
-    PackedStorage  _storage;
+    u32              _freeHead {0};
+    std::vector<H>   _freeList;
+    PackedStorage    _storage;
+    // scratch buffers for removeN, kept to avoid allocating on every batch
+    std::vector<u32> _releasedIndices;
+    std::vector<u8>  _releasedMarks;
 };
-}
+}  // namespace hq
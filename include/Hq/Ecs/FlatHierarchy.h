@@ -0,0 +1,408 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/Ecs/HierarchicalComponent.h"
+#include "Hq/FlatHashMap.h"
+#include "Hq/JobManager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace hq
+{
+/// Flattened copy of the hierarchies built with a HierarchicalComponent: entities are stored in depth-first order
+/// in contiguous arrays together with the index of their parent, the size of their subtree and their depth.
+/// A parent always comes before its children and a subtree is the contiguous range [index, index + subtreeSize),
+/// so propagating data from parents to children (world transforms...) is a single linear pass over the arrays
+/// instead of pointer chasing through the registry.
+/// The registry stays the source of truth: call `build` once, then `reparent`/`add` after changing the links of an
+/// entity and `remove` before destroying a subtree.
+/// `reparent` of an unchanged subtree rotates the entries between its old and new positions and only re-indexes
+/// those, `add`, `remove` and a reparent that also changed the children of the subtree shift and re-index every
+/// entry after the edit point (O(n) from there).
+/// @note Siblings keep the order of the linked list on `build`, a reparented subtree goes after its new siblings.
+/// @example usage:
+///     FlatHierarchy<TransformHierarchy> flat;
+///     flat.build(registry);
+///     for (u32 i = 0; i < flat.size(); ++i)
+///         world[i] = flat.parent(i) == kNoParent ? local[i] : mul(world[flat.parent(i)], local[i]);
+template <typename HierarchicalComp>
+class FlatHierarchy
+{
+public:
+    static constexpr u32 kNoParent = 0xffffffffu;
+
+    /// Flattens every hierarchy of the registry, roots are the entities without parent
+    void build(entt::registry& registry)
+    {
+        clear();
+        for (entt::entity entity : registry.view<HierarchicalComp>())
+        {
+            if (registry.get<HierarchicalComp>(entity).parent == entt::null)
+                flatten(registry, entity, kNoParent, 0, _entities.size());
+        }
+        rebuildIndices(0, _entities.size());
+    }
+
+    void clear()
+    {
+        _entities.clear();
+        _parents.clear();
+        _subtreeSizes.clear();
+        _depths.clear();
+        _indices.clear();
+    }
+
+    /// Adds a new entity (and the subtree already linked under it) under its parent
+    void add(entt::registry& registry, entt::entity entity)
+    {
+        assert(!contains(entity));
+        insert(registry, entity);
+    }
+
+    /// Moves the subtree of `entity` under its current parent, call it once the links of the components changed.
+    /// Children linked or unlinked under `entity` since the last update are picked up too.
+    void reparent(entt::registry& registry, entt::entity entity)
+    {
+        if (!contains(entity))
+            insert(registry, entity);
+        else if (!move(registry, entity))
+        {
+            erase(indexOf(entity));
+            insert(registry, entity);
+        }
+    }
+
+    /// Removes `entity` and its subtree, call it before destroying them in the registry
+    void remove(entt::entity entity)
+    {
+        if (contains(entity))
+            erase(indexOf(entity));
+    }
+
+    u32 size() const
+    {
+        return static_cast<u32>(_entities.size());
+    }
+
+    bool contains(entt::entity entity) const
+    {
+        return _indices.contains(entity);
+    }
+
+    u32 indexOf(entt::entity entity) const
+    {
+        assert(contains(entity));
+        return _indices.at(entity);
+    }
+
+    entt::entity entity(u32 index) const
+    {
+        return _entities[index];
+    }
+
+    /// Index of the parent, kNoParent for roots
+    u32 parent(u32 index) const
+    {
+        return _parents[index];
+    }
+
+    /// Number of entities in the subtree of `index`, itself included
+    u32 subtreeSize(u32 index) const
+    {
+        return _subtreeSizes[index];
+    }
+
+    /// 0 for roots
+    u32 depth(u32 index) const
+    {
+        return _depths[index];
+    }
+
+    const std::vector<entt::entity>& entities() const
+    {
+        return _entities;
+    }
+
+    const std::vector<u32>& parents() const
+    {
+        return _parents;
+    }
+
+    const std::vector<u32>& subtreeSizes() const
+    {
+        return _subtreeSizes;
+    }
+
+    const std::vector<u32>& depths() const
+    {
+        return _depths;
+    }
+
+    /// Calls `func(u32 index, u32 parentIndex)` parents first, in one linear pass
+    template <typename F>
+    void forEach(F&& func) const
+    {
+        for (u32 i = 0; i < size(); ++i)
+            func(i, _parents[i]);
+    }
+
+    /// Calls `func(u32 index, u32 parentIndex)` from the job manager workers, a parent is always processed before
+    /// its children. Subtrees small enough for one batch are independent jobs processed in order, the few ancestors
+    /// of bigger subtrees are processed first on the calling thread.
+    /// `func` must be safe to call concurrently for different indices.
+    template <typename F>
+    void forEachParallel(JobManager& jobManager, F&& func)
+    {
+        _ranges.clear();
+        for (u32 i = 0; i < size();)
+        {
+            const u32 count = _subtreeSizes[i];
+            if (count > kHierarchyParallelBatchSize)
+            {
+                func(i, _parents[i]);
+                ++i;
+                continue;
+            }
+
+            // merge neighbour subtrees in the same batch
+            if (!_ranges.empty() && _ranges.back().first + _ranges.back().count == i &&
+                _ranges.back().count + count <= kHierarchyParallelBatchSize)
+                _ranges.back().count += count;
+            else
+                _ranges.push_back({i, count});
+            i += count;
+        }
+
+        jobManager.parallel_for<Range, CountSplitter<Range, 1>>(
+            [this, &func](void* data, size_t count) {
+                const Range* ranges = static_cast<const Range*>(data);
+                for (size_t r = 0; r < count; ++r)
+                {
+                    for (u32 i = ranges[r].first; i < ranges[r].first + ranges[r].count; ++i)
+                        func(i, _parents[i]);
+                }
+            },
+            _ranges.data(), _ranges.size());
+        jobManager.wait();
+    }
+
+private:
+    struct Range
+    {
+        u32 first;
+        u32 count;
+    };
+
+    // walks the subtree of `root` in depth-first order into the scratch arrays, parents are indexed as if the
+    // subtree started at `position`, returns its size
+    u32 flattenScratch(entt::registry& registry, entt::entity root, u32 rootParent, u32 rootDepth, size_t position)
+    {
+        _stack.clear();
+        _stackParents.clear();
+        _stack.push_back(root);
+        u32 count = 0;
+
+        std::vector<entt::entity>& entities = _scratchEntities;
+        std::vector<u32>&          parents  = _scratchParents;
+        std::vector<u32>&          depths   = _scratchDepths;
+        entities.clear();
+        parents.clear();
+        depths.clear();
+        while (!_stack.empty())
+        {
+            const entt::entity entity = _stack.back();
+            _stack.pop_back();
+
+            const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
+            const u32               index     = static_cast<u32>(position) + count++;
+            u32                     parent    = rootParent;
+            u32                     depth     = rootDepth;
+            if (entity != root)
+            {
+                // parents are already flattened, their index was recorded when pushing the children
+                parent = _stackParents.back();
+                _stackParents.pop_back();
+                depth = depths[parent - position] + 1;
+            }
+            entities.push_back(entity);
+            parents.push_back(parent);
+            depths.push_back(depth);
+
+            // push children in reverse so the first child is visited first
+            const size_t firstPushed = _stack.size();
+            for (entt::entity child = component.firstChild; child != entt::null;
+                 child              = registry.get<HierarchicalComp>(child).nextSibling)
+            {
+                _stack.push_back(child);
+                _stackParents.push_back(index);
+            }
+            std::reverse(_stack.begin() + firstPushed, _stack.end());
+        }
+        return count;
+    }
+
+    // inserts the subtree of `root` in depth-first order at `position`, returns its size
+    u32 flatten(entt::registry& registry, entt::entity root, u32 rootParent, u32 rootDepth, size_t position)
+    {
+        const u32                        count    = flattenScratch(registry, root, rootParent, rootDepth, position);
+        const std::vector<entt::entity>& entities = _scratchEntities;
+        const std::vector<u32>&          parents  = _scratchParents;
+        const std::vector<u32>&          depths   = _scratchDepths;
+        _entities.insert(_entities.begin() + position, entities.begin(), entities.end());
+        _parents.insert(_parents.begin() + position, parents.begin(), parents.end());
+        _depths.insert(_depths.begin() + position, depths.begin(), depths.end());
+        _subtreeSizes.insert(_subtreeSizes.begin() + position, count, 1);
+
+        // children come after their parent, accumulate sizes backwards
+        for (size_t i = position + count; i-- > position + 1;)
+            _subtreeSizes[_parents[i]] += _subtreeSizes[i];
+
+        return count;
+    }
+
+    void insert(entt::registry& registry, entt::entity entity)
+    {
+        const entt::entity parentEntity = registry.get<HierarchicalComp>(entity).parent;
+        u32                parent       = kNoParent;
+        u32                depth        = 0;
+        size_t             position     = _entities.size();
+        if (parentEntity != entt::null)
+        {
+            parent   = indexOf(parentEntity);
+            depth    = _depths[parent] + 1;
+            position = parent + _subtreeSizes[parent];
+        }
+
+        // entries after the insertion point move, fix the parent indices pointing to them
+        const size_t oldSize = _entities.size();
+        const u32    count   = flatten(registry, entity, parent, depth, position);
+        for (size_t i = position + count; i < oldSize + count; ++i)
+        {
+            if (_parents[i] != kNoParent && _parents[i] >= position)
+                _parents[i] += count;
+        }
+
+        for (u32 ancestor = parent; ancestor != kNoParent; ancestor = _parents[ancestor])
+            _subtreeSizes[ancestor] += count;
+
+        rebuildIndices(position, _entities.size());
+    }
+
+    // moves the flattened subtree of `entity` under its new parent if the subtree itself is unchanged, only the
+    // entries between the old and new positions move, returns false if the subtree must be flattened again
+    bool move(entt::registry& registry, entt::entity entity)
+    {
+        const u32 from  = indexOf(entity);
+        const u32 count = _subtreeSizes[from];
+        if (flattenScratch(registry, entity, kNoParent, 0, 0) != count ||
+            !std::equal(_scratchEntities.begin(), _scratchEntities.end(), _entities.begin() + from))
+            return false;
+
+        const entt::entity parentEntity = registry.get<HierarchicalComp>(entity).parent;
+        u32                parent       = kNoParent;
+        u32                depth        = 0;
+        u32                position     = size();
+        if (parentEntity != entt::null)
+        {
+            parent   = indexOf(parentEntity);
+            depth    = _depths[parent] + 1;
+            position = parent + _subtreeSizes[parent];
+        }
+        assert(parent == kNoParent || parent < from || parent >= from + count);
+
+        // the subtree moves forward or backward over the entries [lo, hi)
+        const bool forward = position >= from + count;
+        const u32  lo      = forward ? from : position;
+        const u32  hi      = forward ? position : from + count;
+        const u32  middle  = forward ? from + count : from;
+        auto       moved   = [&](u32 index) {
+            if (index == kNoParent || index < lo || index >= hi)
+                return index;
+            if (forward)
+                return index < from + count ? index + hi - from - count : index - count;
+            return index >= from ? index - (from - lo) : index + count;
+        };
+
+        // entries after the range whose parent is inside it: children of the ancestors of `hi` that straddle it
+        _fixups.clear();
+        if (hi < size())
+        {
+            u32 child = hi;
+            for (u32 ancestor = _parents[hi]; ancestor != kNoParent && ancestor >= lo;
+                 child        = ancestor, ancestor = _parents[ancestor])
+            {
+                for (u32 c = child == hi ? hi : child + _subtreeSizes[child]; c < ancestor + _subtreeSizes[ancestor];
+                     c += _subtreeSizes[c])
+                    _fixups.push_back(c);
+            }
+        }
+
+        for (u32 ancestor = _parents[from]; ancestor != kNoParent; ancestor = _parents[ancestor])
+            _subtreeSizes[ancestor] -= count;
+        for (u32 ancestor = parent; ancestor != kNoParent; ancestor = _parents[ancestor])
+            _subtreeSizes[ancestor] += count;
+
+        const u32 oldDepth = _depths[from];
+        for (u32 i = from; i < from + count; ++i)
+            _depths[i] = _depths[i] - oldDepth + depth;
+        _parents[from] = parent;
+        for (u32 i = lo; i < hi; ++i)
+            _parents[i] = moved(_parents[i]);
+        for (u32 i : _fixups)
+            _parents[i] = moved(_parents[i]);
+
+        std::rotate(_entities.begin() + lo, _entities.begin() + middle, _entities.begin() + hi);
+        std::rotate(_parents.begin() + lo, _parents.begin() + middle, _parents.begin() + hi);
+        std::rotate(_subtreeSizes.begin() + lo, _subtreeSizes.begin() + middle, _subtreeSizes.begin() + hi);
+        std::rotate(_depths.begin() + lo, _depths.begin() + middle, _depths.begin() + hi);
+        rebuildIndices(lo, hi);
+        return true;
+    }
+
+    void erase(u32 index)
+    {
+        const u32 count = _subtreeSizes[index];
+        for (u32 ancestor = _parents[index]; ancestor != kNoParent; ancestor = _parents[ancestor])
+            _subtreeSizes[ancestor] -= count;
+
+        for (u32 i = index; i < index + count; ++i)
+            _indices.erase(_entities[i]);
+
+        _entities.erase(_entities.begin() + index, _entities.begin() + index + count);
+        _parents.erase(_parents.begin() + index, _parents.begin() + index + count);
+        _subtreeSizes.erase(_subtreeSizes.begin() + index, _subtreeSizes.begin() + index + count);
+        _depths.erase(_depths.begin() + index, _depths.begin() + index + count);
+
+        for (size_t i = index; i < _entities.size(); ++i)
+        {
+            if (_parents[i] != kNoParent && _parents[i] > index)
+                _parents[i] -= count;
+        }
+
+        rebuildIndices(index, _entities.size());
+    }
+
+    void rebuildIndices(size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; ++i)
+            _indices[_entities[i]] = static_cast<u32>(i);
+    }
+
+private:
+    std::vector<entt::entity>      _entities;
+    std::vector<u32>               _parents;
+    std::vector<u32>               _subtreeSizes;
+    std::vector<u32>               _depths;
+    FlatHashMap<entt::entity, u32> _indices;
+    // scratch of the iterative depth-first walk
+    std::vector<entt::entity>      _stack;
+    std::vector<u32>               _stackParents;
+    std::vector<entt::entity>      _scratchEntities;
+    std::vector<u32>               _scratchParents;
+    std::vector<u32>               _scratchDepths;
+    std::vector<u32>               _fixups;
+    std::vector<Range>             _ranges;
+};
+}  // namespace hq
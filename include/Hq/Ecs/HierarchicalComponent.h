@@ -3,12 +3,43 @@
 #include "entt/fwd.hpp"
 #include "entt/entity/entity.hpp"
 #include "entt/entity/registry.hpp"
-#include "hq/BasicTypes.h"
+#include "Hq/BasicTypes.h"
+#include "Hq/JobManager.h"
 
-#include <queue>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 
 namespace hq
 {
+static const size_t kHierarchyParallelBatchSize = 256;
+
+/// Scratch stack of the depth-first visitors, they don't recurse so deep chains (ropes, bones...) can't overflow the
+/// call stack. Keep one around to visit without allocating.
+struct HierarchyStack
+{
+    std::vector<entt::entity> entities;
+    std::vector<u8>           expanded;  // post-order only, children of the entity already pushed
+};
+
+/// Scratch buffers of the breadth-first visitors, keep one around to visit without allocating
+struct HierarchyFrontier
+{
+    std::vector<entt::entity> current;
+    std::vector<entt::entity> next;
+};
+
+/// Scratch buffers of InstantiateSubtree, keep one around to instantiate prefabs without allocating
+struct HierarchyCopy
+{
+    std::vector<entt::entity> sources;    // depth-first order
+    std::vector<u32>          parents;    // index of the parent in `sources`
+    std::vector<entt::entity> copies;     // same order as `sources`
+    std::vector<entt::entity> lastChild;  // last linked child of each copy
+    std::vector<entt::entity> stack;
+    std::vector<u32>          stackParents;
+};
+
 template <typename T>
 struct HierarchicalComponent
 {
@@ -27,10 +58,10 @@ struct HierarchicalComponent
     }
 };
 
-template <typename HierarchicalComp, typename VisitorF>
-void VisitHierarchyDepthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+// appends the children of `entity` to `frontier`
+template <typename HierarchicalComp>
+void PushHierarchyChildren(entt::registry& registry, entt::entity entity, std::vector<entt::entity>& frontier)
 {
-    visitor(registry, entity);
     assert(registry.any_of<HierarchicalComp>(entity));
     const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
     HierarchicalComp*       childComp = nullptr;
@@ -39,101 +70,367 @@ void VisitHierarchyDepthFirst(entt::registry& registry, entt::entity entity, Vis
     {
         do
         {
-            VisitHierarchyDepthFirst<HierarchicalComp, VisitorF>(registry, nextChild, visitor);
+            frontier.push_back(nextChild);
             childComp = registry.try_get<HierarchicalComp>(nextChild);
         } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
     }
 }
 
+/// Returns true if `ancestor` is `entity` or one of its ancestors
+template <typename HierarchicalComp>
+bool IsInHierarchy(const entt::registry& registry, entt::entity ancestor, entt::entity entity)
+{
+    for (; entity != entt::null; entity = registry.get<HierarchicalComp>(entity).parent)
+    {
+        if (entity == ancestor)
+            return true;
+    }
+    return false;
+}
+
+/// Unlinks `entity` (and its subtree) from its parent and siblings, it becomes a root. O(1)
+template <typename HierarchicalComp>
+void Detach(entt::registry& registry, entt::entity entity)
+{
+    HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
+    if (component.prevSibling != entt::null)
+        registry.get<HierarchicalComp>(component.prevSibling).nextSibling = component.nextSibling;
+    else if (component.parent != entt::null)
+        registry.get<HierarchicalComp>(component.parent).firstChild = component.nextSibling;
+
+    if (component.nextSibling != entt::null)
+        registry.get<HierarchicalComp>(component.nextSibling).prevSibling = component.prevSibling;
+
+    component.parent      = entt::null;
+    component.prevSibling = entt::null;
+    component.nextSibling = entt::null;
+}
+
+/// Links the root `entity` as a child of `parent`, before the child `before` in O(1) or as last child when `before`
+/// is null (walks the children of `parent`)
+template <typename HierarchicalComp>
+void Attach(entt::registry& registry, entt::entity entity, entt::entity parent, entt::entity before = entt::null)
+{
+    HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
+    assert(component.parent == entt::null && component.prevSibling == entt::null &&
+           component.nextSibling == entt::null && "detach the entity first");
+    assert(!IsInHierarchy<HierarchicalComp>(registry, entity, parent) && "an entity can't be its own ancestor");
+
+    HierarchicalComp& parentComponent = registry.get<HierarchicalComp>(parent);
+    component.parent                  = parent;
+    if (before != entt::null)
+    {
+        HierarchicalComp& beforeComponent = registry.get<HierarchicalComp>(before);
+        assert(beforeComponent.parent == parent);
+        component.prevSibling = beforeComponent.prevSibling;
+        component.nextSibling = before;
+        if (beforeComponent.prevSibling != entt::null)
+            registry.get<HierarchicalComp>(beforeComponent.prevSibling).nextSibling = entity;
+        else
+            parentComponent.firstChild = entity;
+        beforeComponent.prevSibling = entity;
+        return;
+    }
+
+    if (parentComponent.firstChild == entt::null)
+    {
+        parentComponent.firstChild = entity;
+        return;
+    }
+
+    entt::entity last = parentComponent.firstChild;
+    for (entt::entity next; (next = registry.get<HierarchicalComp>(last).nextSibling) != entt::null;)
+        last = next;
+    registry.get<HierarchicalComp>(last).nextSibling = entity;
+    component.prevSibling                            = last;
+}
+
+/// Moves `entity` and its subtree under `parent` (a root when null), before the child `before` in O(1) or last
+/// (walks the children of `parent`, like Attach)
+template <typename HierarchicalComp>
+void Reparent(entt::registry& registry, entt::entity entity, entt::entity parent, entt::entity before = entt::null)
+{
+    Detach<HierarchicalComp>(registry, entity);
+    if (parent != entt::null)
+        Attach<HierarchicalComp>(registry, entity, parent, before);
+}
+
+/// Reorders `entity` before its sibling `sibling`. O(1)
+template <typename HierarchicalComp>
+void MoveBefore(entt::registry& registry, entt::entity entity, entt::entity sibling)
+{
+    if (entity == sibling)
+        return;
+    const entt::entity parent = registry.get<HierarchicalComp>(entity).parent;
+    assert(parent != entt::null && registry.get<HierarchicalComp>(sibling).parent == parent);
+    Detach<HierarchicalComp>(registry, entity);
+    Attach<HierarchicalComp>(registry, entity, parent, sibling);
+}
+
+/// Copies the subtree of `root` (prefab instantiation) and links the copy as last child of `parent` (walks the
+/// children of `parent`, like Attach), or as a root when null. The components listed in `Components` are copied,
+/// the hierarchy links are remapped to the new entities. Entities are created in one batch and every component
+/// type is copied in one pass over the subtree.
+/// Returns the root of the copy.
+/// @example usage:
+///     HierarchyCopy scratch;  // kept around
+///     entt::entity  enemy = InstantiateSubtree<SceneHierarchy, LocalTransform>(registry, prefab, level, scratch);
+template <typename HierarchicalComp, typename... Components>
+entt::entity InstantiateSubtree(entt::registry& registry, entt::entity root, entt::entity parent,
+                                HierarchyCopy& scratch)
+{
+    static_assert(!(std::is_same_v<HierarchicalComp, Components> || ...),
+                  "the hierarchy component is remapped, don't list it in Components");
+
+    // depth-first list of the source entities with the index of their parent in the list
+    std::vector<entt::entity>& sources      = scratch.sources;
+    std::vector<u32>&          parents      = scratch.parents;
+    std::vector<entt::entity>& stack        = scratch.stack;
+    std::vector<u32>&          stackParents = scratch.stackParents;
+    sources.clear();
+    parents.clear();
+    stack.assign(1, root);
+    stackParents.assign(1, 0xffffffffu);
+    while (!stack.empty())
+    {
+        const entt::entity entity = stack.back();
+        stack.pop_back();
+        parents.push_back(stackParents.back());
+        stackParents.pop_back();
+        sources.push_back(entity);
+
+        const size_t firstChild = stack.size();
+        PushHierarchyChildren<HierarchicalComp>(registry, entity, stack);
+        std::reverse(stack.begin() + firstChild, stack.end());
+        stackParents.resize(stack.size(), static_cast<u32>(sources.size() - 1));
+    }
+
+    const size_t               count  = sources.size();
+    std::vector<entt::entity>& copies = scratch.copies;
+    copies.resize(count);
+    registry.create(copies.begin(), copies.end());
+
+    // children are visited in order, keep the last one of each parent to link siblings in O(1)
+    std::vector<entt::entity>& lastChild = scratch.lastChild;
+    lastChild.assign(count, entt::null);
+    for (size_t i = 0; i < count; ++i)
+    {
+        HierarchicalComp& component = registry.emplace<HierarchicalComp>(copies[i]);
+        if (i == 0)
+            continue;
+
+        const u32 parentIndex = parents[i];
+        component.parent      = copies[parentIndex];
+        component.prevSibling = lastChild[parentIndex];
+        if (lastChild[parentIndex] != entt::null)
+            registry.get<HierarchicalComp>(lastChild[parentIndex]).nextSibling = copies[i];
+        else
+            registry.get<HierarchicalComp>(copies[parentIndex]).firstChild = copies[i];
+        lastChild[parentIndex] = copies[i];
+    }
+
+    auto copyComponent = [&](auto* type) {
+        using Component = std::remove_pointer_t<decltype(type)>;
+        for (size_t i = 0; i < count; ++i)
+        {
+            // copied first, emplacing can move the storage of the source
+            if (const Component* component = registry.try_get<Component>(sources[i]))
+            {
+                const Component copy = *component;
+                registry.emplace<Component>(copies[i], copy);
+            }
+        }
+    };
+    (copyComponent(static_cast<Components*>(nullptr)), ...);
+
+    if (parent != entt::null)
+        Attach<HierarchicalComp>(registry, copies[0], parent);
+    return copies[0];
+}
+
+template <typename HierarchicalComp, typename... Components>
+entt::entity InstantiateSubtree(entt::registry& registry, entt::entity root, entt::entity parent = entt::null)
+{
+    HierarchyCopy scratch;
+    return InstantiateSubtree<HierarchicalComp, Components...>(registry, root, parent, scratch);
+}
+
 template <typename HierarchicalComp, typename VisitorF>
-void VisitHierarchyDepthFirstPost(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+void VisitHierarchyDepthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor, HierarchyStack& stack)
 {
-    assert(registry.any_of<HierarchicalComp>(entity));
-    const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
-    HierarchicalComp*       childComp = nullptr;
-    entt::entity            nextChild = component.firstChild;
-    if (nextChild != entt::null)
+    std::vector<entt::entity>& entities = stack.entities;
+    entities.clear();
+    entities.push_back(entity);
+    while (!entities.empty())
     {
-        do
+        const entt::entity currentEntity = entities.back();
+        entities.pop_back();
+        visitor(registry, currentEntity);
+
+        // reversed so the first child is on top
+        const size_t firstChild = entities.size();
+        PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, entities);
+        std::reverse(entities.begin() + firstChild, entities.end());
+    }
+}
+
+template <typename HierarchicalComp, typename VisitorF>
+void VisitHierarchyDepthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+{
+    HierarchyStack stack;
+    VisitHierarchyDepthFirst<HierarchicalComp, VisitorF>(registry, entity, visitor, stack);
+}
+
+/// Children are visited before their parent
+template <typename HierarchicalComp, typename VisitorF>
+void VisitHierarchyDepthFirstPost(entt::registry& registry, entt::entity entity, VisitorF& visitor,
+                                  HierarchyStack& stack)
+{
+    std::vector<entt::entity>& entities = stack.entities;
+    std::vector<u8>&           expanded = stack.expanded;
+    entities.clear();
+    expanded.clear();
+    entities.push_back(entity);
+    expanded.push_back(0);
+    while (!entities.empty())
+    {
+        const entt::entity currentEntity = entities.back();
+        if (expanded.back())
         {
-            VisitHierarchyDepthFirst<HierarchicalComp, VisitorF>(registry, nextChild, visitor);
-            childComp = registry.try_get<HierarchicalComp>(nextChild);
-        } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
+            // all children done
+            entities.pop_back();
+            expanded.pop_back();
+            visitor(registry, currentEntity);
+            continue;
+        }
+
+        expanded.back()         = 1;
+        const size_t firstChild = entities.size();
+        PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, entities);
+        std::reverse(entities.begin() + firstChild, entities.end());
+        expanded.resize(entities.size(), 0);
+    }
+}
+
+template <typename HierarchicalComp, typename VisitorF>
+void VisitHierarchyDepthFirstPost(entt::registry& registry, entt::entity entity, VisitorF& visitor)
+{
+    HierarchyStack stack;
+    VisitHierarchyDepthFirstPost<HierarchicalComp, VisitorF>(registry, entity, visitor, stack);
+}
+
+/// Pre-order visit, the subtree of an entity is skipped when the visitor returns false for it
+template <typename HierarchicalComp, typename VisitorPredicateF>
+void VisitHierarchyDepthFirstWithPredicate(entt::registry& registry, entt::entity entity, VisitorPredicateF& visitor,
+                                           HierarchyStack& stack)
+{
+    std::vector<entt::entity>& entities = stack.entities;
+    entities.clear();
+    entities.push_back(entity);
+    while (!entities.empty())
+    {
+        const entt::entity currentEntity = entities.back();
+        entities.pop_back();
+        if (!visitor(registry, currentEntity))
+            continue;
+
+        const size_t firstChild = entities.size();
+        PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, entities);
+        std::reverse(entities.begin() + firstChild, entities.end());
     }
-    visitor(registry, entity);
 }
 
 template <typename HierarchicalComp, typename VisitorPredicateF>
 void VisitHierarchyDepthFirstWithPredicate(entt::registry& registry, entt::entity entity, VisitorPredicateF& visitor)
 {
-    if (visitor(registry, entity))
+    HierarchyStack stack;
+    VisitHierarchyDepthFirstWithPredicate<HierarchicalComp, VisitorPredicateF>(registry, entity, visitor, stack);
+}
+
+template <typename HierarchicalComp, typename VisitorF>
+void VisitHierarchyBreadthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor,
+                                HierarchyFrontier& frontier)
+{
+    frontier.current.clear();
+    frontier.current.push_back(entity);
+    while (!frontier.current.empty())
     {
-        assert(registry.any_of<HierarchicalComp>(entity));
-        const HierarchicalComp& component = registry.get<HierarchicalComp>(entity);
-        HierarchicalComp*       childComp = nullptr;
-        entt::entity            nextChild = component.firstChild;
-        if (nextChild != entt::null)
+        frontier.next.clear();
+        for (entt::entity currentEntity : frontier.current)
         {
-            do
-            {
-                VisitHierarchyDepthFirst<HierarchicalComp, VisitorPredicateF>(registry, nextChild, visitor);
-                childComp = registry.try_get<HierarchicalComp>(nextChild);
-            } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
+            visitor(registry, currentEntity);
+            PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, frontier.next);
         }
+        std::swap(frontier.current, frontier.next);
     }
 }
 
 template <typename HierarchicalComp, typename VisitorF>
 void VisitHierarchyBreadthFirst(entt::registry& registry, entt::entity entity, VisitorF& visitor)
 {
-    std::queue<entt::entity> queue;
-    queue.push(entity);
-    entt::entity currentEntity = entt::null;
-    while (!queue.empty())
+    HierarchyFrontier frontier;
+    VisitHierarchyBreadthFirst<HierarchicalComp, VisitorF>(registry, entity, visitor, frontier);
+}
+
+template <typename HierarchicalComp, typename VisitorPredicateF>
+void VisitHierarchyBreadthFirstWithPredicate(entt::registry& registry, entt::entity entity, VisitorPredicateF& visitor,
+                                             HierarchyFrontier& frontier)
+{
+    frontier.current.clear();
+    frontier.current.push_back(entity);
+    while (!frontier.current.empty())
     {
-        currentEntity = queue.front();
-        queue.pop();
-        visitor(registry, currentEntity);
-        assert(registry.any_of<HierarchicalComp>(currentEntity));
-        const HierarchicalComp& component = registry.get<HierarchicalComp>(currentEntity);
-        HierarchicalComp*       childComp = nullptr;
-        entt::entity            nextChild = component.firstChild;
-        if (nextChild != entt::null)
+        frontier.next.clear();
+        for (entt::entity currentEntity : frontier.current)
         {
-            do
-            {
-                queue.emplace(nextChild);
-                childComp = registry.try_get<HierarchicalComp>(nextChild);
-            } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
+            if (visitor(registry, currentEntity))
+                PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, frontier.next);
         }
+        std::swap(frontier.current, frontier.next);
     }
 }
 
 template <typename HierarchicalComp, typename VisitorPredicateF>
 void VisitHierarchyBreadthFirstWithPredicate(entt::registry& registry, entt::entity entity, VisitorPredicateF& visitor)
 {
-    std::queue<entt::entity> queue;
-    queue.push(entity);
-    entt::entity currentEntity = entt::null;
-    while (!queue.empty())
+    HierarchyFrontier frontier;
+    VisitHierarchyBreadthFirstWithPredicate<HierarchicalComp, VisitorPredicateF>(registry, entity, visitor, frontier);
+}
+
+/// Breadth-first visit from the job manager workers, one level at a time: every entity of a level is visited in
+/// parallel and the level is finished before its children are visited, so a visitor can read what the visitor of
+/// the parent wrote (world transforms...).
+/// `visitor(registry, entity)` must be safe to call concurrently for different entities of the same level and must
+/// not add or remove components. Levels narrower than kHierarchyParallelBatchSize are visited on the calling thread.
+template <typename HierarchicalComp, typename VisitorF>
+void VisitHierarchyBreadthFirstParallel(JobManager& jobManager, entt::registry& registry, entt::entity entity,
+                                        VisitorF& visitor, HierarchyFrontier& frontier)
+{
+    frontier.current.clear();
+    frontier.current.push_back(entity);
+    while (!frontier.current.empty())
     {
-        currentEntity = queue.front();
-        queue.pop();
-        if (visitor(registry, currentEntity))
+        if (frontier.current.size() > kHierarchyParallelBatchSize)
         {
-            assert(registry.any_of<HierarchicalComp>(currentEntity));
-            const HierarchicalComp& component = registry.get<HierarchicalComp>(currentEntity);
-            HierarchicalComp*       childComp = nullptr;
-            entt::entity            nextChild = component.firstChild;
-            if (nextChild != entt::null)
-            {
-                do
-                {
-                    queue.emplace(nextChild);
-                    childComp = registry.try_get<HierarchicalComp>(nextChild);
-                } while (childComp && ((nextChild = childComp->nextSibling) != entt::null));
-            }
+            jobManager.parallel_for<entt::entity, CountSplitter<entt::entity, kHierarchyParallelBatchSize>>(
+                [&registry, &visitor](void* data, size_t count) {
+                    entt::entity* entities = static_cast<entt::entity*>(data);
+                    for (size_t i = 0; i < count; ++i)
+                        visitor(registry, entities[i]);
+                },
+                frontier.current.data(), frontier.current.size());
+            jobManager.wait();
         }
+        else
+        {
+            for (entt::entity currentEntity : frontier.current)
+                visitor(registry, currentEntity);
+        }
+
+        frontier.next.clear();
+        for (entt::entity currentEntity : frontier.current)
+            PushHierarchyChildren<HierarchicalComp>(registry, currentEntity, frontier.next);
+        std::swap(frontier.current, frontier.next);
     }
 }
 
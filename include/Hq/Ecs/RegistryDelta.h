@@ -0,0 +1,399 @@
+#pragma once
+
+#include "entt/fwd.hpp"
+#include "entt/entity/entity.hpp"
+#include "entt/entity/registry.hpp"
+#include "Hq/BasicTypes.h"
+#include "Hq/BinarySerializer.h"
+#include "Hq/FlatHashMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iosfwd>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace hq
+{
+/// Delta encoding of the `Components` of a registry between two states, to stream a world to observers or write
+/// replays without a full RegistrySnapshot every tick.
+/// The encoder keeps the state it sent last as base, `encode` compares every pool to it component by component:
+/// - removed and added entities are listed, added components are sent whole
+/// - components of the other entities are XORed with the base 4 bytes at a time, unchanged components are skipped in
+///   runs (varint counts) and a changed one is sent as a bit mask of its changed words followed by those words only
+/// The receiver keeps the same base and must apply every delta in order, `apply` writes the changed components in
+/// its registry and creates/destroys entities with the same identifiers.
+/// A delta that fails to apply (corrupted, truncated, lost) resets the receiver: its registry may be partially
+/// updated, so clear it and have the sender `reset` to start again from the whole state.
+/// Components must be trivially copyable, they are compared and patched as raw bytes.
+/// @example usage:
+///     RegistryDelta<Position, Velocity> encoder;  // server, one per observer
+///     encoder.encode(world, stream);
+///     RegistryDelta<Position, Velocity> decoder;  // observer
+///     decoder.apply(observedWorld, stream);
+template <typename... Components>
+class RegistryDelta
+{
+    static_assert((std::is_trivially_copyable_v<Components> && ...), "RegistryDelta needs trivially copyable components");
+
+public:
+    static constexpr u32 kDeltaMagic   = 0x48514454;  // HQDT
+    static constexpr u32 kDeltaVersion = 1;
+
+    /// Writes the changes since the last `encode`, the whole state the first time or after `reset`
+    void encode(entt::registry& registry, std::ostream& out)
+    {
+        _buffer.clear();
+        (encodePool<Components>(registry), ...);
+
+        BinarySerializer serializer(out);
+        serializer(kDeltaMagic);
+        serializer(kDeltaVersion);
+        serializer(static_cast<u32>(sizeof...(Components)));
+        serializer(static_cast<u64>(_buffer.size()));
+        serializer.write(_buffer.data(), _buffer.size());
+    }
+
+    /// Applies the next delta written by `encode`, returns false and resets the base if it is invalid
+    bool apply(entt::registry& registry, std::istream& in)
+    {
+        if (applyDelta(registry, in))
+            return true;
+        reset();
+        return false;
+    }
+
+    /// Forgets the base, the next delta contains the whole state (new observer, lost packet...)
+    void reset()
+    {
+        std::apply([](auto&... pools) { (pools.clear(), ...); }, _pools);
+    }
+
+private:
+    // read in chunks, a corrupted size fails at the end of the stream instead of allocating it
+    static constexpr size_t kReadChunkSize = 64 * 1024;
+
+    bool applyDelta(entt::registry& registry, std::istream& in)
+    {
+        BinaryDeserializer deserializer(in);
+        u32                magic = 0, version = 0, count = 0;
+        u64                size  = 0;
+        deserializer(magic);
+        deserializer(version);
+        deserializer(count);
+        deserializer(size);
+        if (!in || magic != kDeltaMagic || version != kDeltaVersion || count != sizeof...(Components))
+            return false;
+
+        _buffer.clear();
+        while (_buffer.size() < size)
+        {
+            const size_t offset = _buffer.size();
+            const size_t chunk  = static_cast<size_t>(std::min<u64>(size - offset, kReadChunkSize));
+            _buffer.resize(offset + chunk);
+            if (!deserializer.read(_buffer.data() + offset, chunk))
+                return false;
+        }
+
+        _read = 0;
+        _destroyed.clear();
+        if (!(applyPool<Components>(registry) && ...) || _read != _buffer.size())
+            return false;
+
+        // entities removed from every pool are gone
+        for (entt::entity entity : _destroyed)
+        {
+            if (registry.valid(entity) && !registry.any_of<Components...>(entity))
+                registry.destroy(entity);
+        }
+        return true;
+    }
+
+    template <typename T>
+    struct Pool
+    {
+        std::vector<entt::entity> entities;
+        std::vector<T>            components;
+
+        void clear()
+        {
+            entities.clear();
+            components.clear();
+        }
+    };
+
+    static constexpr size_t wordCount(size_t size)
+    {
+        return (size + 3) / 4;
+    }
+
+    template <typename T>
+    Pool<T>& pool()
+    {
+        return std::get<Pool<T>>(_pools);
+    }
+
+    template <typename T>
+    Pool<T>& scratchPool()
+    {
+        return std::get<Pool<T>>(_scratch);
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const u8* bytes = static_cast<const u8*>(data);
+        _buffer.insert(_buffer.end(), bytes, bytes + size);
+    }
+
+    void writeVarint(u64 value)
+    {
+        while (value >= 0x80)
+        {
+            _buffer.push_back(static_cast<u8>(value | 0x80));
+            value >>= 7;
+        }
+        _buffer.push_back(static_cast<u8>(value));
+    }
+
+    bool readBytes(void* data, size_t size)
+    {
+        if (size > _buffer.size() - _read)
+            return false;
+        if (size)
+            memcpy(data, _buffer.data() + _read, size);
+        _read += size;
+        return true;
+    }
+
+    bool readVarint(u64& value)
+    {
+        value = 0;
+        for (u32 shift = 0; shift < 64 && _read < _buffer.size(); shift += 7)
+        {
+            const u8 byte = _buffer[_read++];
+            value |= u64(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    static void toWords(const T& component, u32* words)
+    {
+        words[wordCount(sizeof(T)) - 1] = 0;
+        memcpy(words, &component, sizeof(T));
+    }
+
+    template <typename T>
+    void encodePool(entt::registry& registry)
+    {
+        constexpr size_t kWords     = wordCount(sizeof(T));
+        constexpr size_t kMaskBytes = (kWords + 7) / 8;
+
+        Pool<T>& base    = pool<T>();
+        Pool<T>& current = scratchPool<T>();
+        current.clear();
+        _indices.clear();
+        for (entt::entity entity : registry.view<T>())
+        {
+            _indices[entity] = static_cast<u32>(current.entities.size());
+            current.entities.push_back(entity);
+            current.components.push_back(registry.get<T>(entity));
+        }
+
+        // entities of the base still alive keep the base order, the receiver knows it
+        _removed.clear();
+        _common.clear();
+        _isCommon.assign(current.entities.size(), 0);
+        for (u32 b = 0; b < base.entities.size(); ++b)
+        {
+            auto it = _indices.find(base.entities[b]);
+            if (it == _indices.end())
+                _removed.push_back(base.entities[b]);
+            else
+            {
+                _common.push_back({b, it->second});
+                _isCommon[it->second] = 1;
+            }
+        }
+
+        writeVarint(sizeof(T));
+        writeVarint(_removed.size());
+        writeBytes(_removed.data(), _removed.size() * sizeof(entt::entity));
+
+        _added.clear();
+        for (u32 i = 0; i < current.entities.size(); ++i)
+        {
+            if (!_isCommon[i])
+                _added.push_back(i);
+        }
+        writeVarint(_added.size());
+        for (u32 i : _added)
+            writeBytes(&current.entities[i], sizeof(entt::entity));
+        for (u32 i : _added)
+            writeBytes(&current.components[i], sizeof(T));
+
+        // changed components: [unchanged run length][word mask][changed words xor base] ... [final run length]
+        u32 oldWords[kWords], newWords[kWords];
+        u64 unchanged = 0;
+        for (const CommonEntry& entry : _common)
+        {
+            toWords(base.components[entry.baseIndex], oldWords);
+            toWords(current.components[entry.index], newWords);
+
+            u8 mask[kMaskBytes] = {};
+            for (size_t w = 0; w < kWords; ++w)
+            {
+                if (oldWords[w] != newWords[w])
+                    mask[w / 8] |= u8(1u << (w % 8));
+            }
+            bool changed = false;
+            for (u8 byte : mask)
+                changed |= byte != 0;
+            if (!changed)
+            {
+                ++unchanged;
+                continue;
+            }
+
+            writeVarint(unchanged);
+            unchanged = 0;
+            writeBytes(mask, kMaskBytes);
+            for (size_t w = 0; w < kWords; ++w)
+            {
+                if (mask[w / 8] & (1u << (w % 8)))
+                {
+                    const u32 x = oldWords[w] ^ newWords[w];
+                    writeBytes(&x, sizeof(x));
+                }
+            }
+        }
+        writeVarint(unchanged);
+
+        // new base: same order as the receiver builds it
+        Pool<T>& next = std::get<Pool<T>>(_next);
+        next.clear();
+        for (const CommonEntry& entry : _common)
+        {
+            next.entities.push_back(base.entities[entry.baseIndex]);
+            next.components.push_back(current.components[entry.index]);
+        }
+        for (u32 i : _added)
+        {
+            next.entities.push_back(current.entities[i]);
+            next.components.push_back(current.components[i]);
+        }
+        std::swap(base, next);
+    }
+
+    template <typename T>
+    bool applyPool(entt::registry& registry)
+    {
+        constexpr size_t kWords     = wordCount(sizeof(T));
+        constexpr size_t kMaskBytes = (kWords + 7) / 8;
+
+        u64 size = 0, removedCount = 0, addedCount = 0;
+        if (!readVarint(size) || size != sizeof(T) || !readVarint(removedCount) ||
+            removedCount > (_buffer.size() - _read) / sizeof(entt::entity))
+            return false;
+
+        Pool<T>& base = pool<T>();
+        _removed.resize(removedCount);
+        readBytes(_removed.data(), removedCount * sizeof(entt::entity));
+
+        _indices.clear();
+        for (u32 b = 0; b < base.entities.size(); ++b)
+            _indices[base.entities[b]] = b;
+        _isCommon.assign(base.entities.size(), 1);
+        for (entt::entity entity : _removed)
+        {
+            auto it = _indices.find(entity);
+            if (it == _indices.end())
+                return false;
+            _isCommon[it->second] = 0;
+            if (registry.valid(entity))
+                registry.remove<T>(entity);
+            _destroyed.push_back(entity);
+        }
+
+        Pool<T>& next = std::get<Pool<T>>(_next);
+        next.clear();
+        for (u32 b = 0; b < base.entities.size(); ++b)
+        {
+            if (_isCommon[b])
+            {
+                next.entities.push_back(base.entities[b]);
+                next.components.push_back(base.components[b]);
+            }
+        }
+        const size_t commonCount = next.entities.size();
+
+        if (!readVarint(addedCount) || addedCount > (_buffer.size() - _read) / (sizeof(entt::entity) + sizeof(T)))
+            return false;
+        next.entities.resize(commonCount + addedCount);
+        next.components.resize(commonCount + addedCount);
+        readBytes(next.entities.data() + commonCount, addedCount * sizeof(entt::entity));
+        readBytes(next.components.data() + commonCount, addedCount * sizeof(T));
+
+        u32    words[kWords];
+        size_t i = 0;
+        while (true)
+        {
+            u64 unchanged = 0;
+            if (!readVarint(unchanged) || unchanged > commonCount - i)
+                return false;
+            i += unchanged;
+            if (i == commonCount)
+                break;
+
+            u8 mask[kMaskBytes];
+            if (!readBytes(mask, kMaskBytes))
+                return false;
+            toWords(next.components[i], words);
+            for (size_t w = 0; w < kWords; ++w)
+            {
+                u32 x = 0;
+                if ((mask[w / 8] & (1u << (w % 8))) && !readBytes(&x, sizeof(x)))
+                    return false;
+                words[w] ^= x;
+            }
+            memcpy(&next.components[i], words, sizeof(T));
+            registry.emplace_or_replace<T>(next.entities[i], next.components[i]);
+            ++i;
+        }
+
+        for (size_t a = commonCount; a < next.entities.size(); ++a)
+        {
+            const entt::entity entity = next.entities[a];
+            if (entity == entt::null || (!registry.valid(entity) && registry.create(entity) != entity))
+                return false;
+            registry.emplace_or_replace<T>(entity, next.components[a]);
+        }
+
+        std::swap(base, next);
+        return true;
+    }
+
+private:
+    struct CommonEntry
+    {
+        u32 baseIndex;
+        u32 index;
+    };
+
+    std::tuple<Pool<Components>...> _pools;
+    // scratch of an encode/apply, current registry state and next base
+    std::tuple<Pool<Components>...> _scratch;
+    std::tuple<Pool<Components>...> _next;
+    std::vector<u8>                 _buffer;
+    size_t                          _read {0};
+    FlatHashMap<entt::entity, u32>  _indices;
+    std::vector<entt::entity>       _removed;
+    std::vector<entt::entity>       _destroyed;
+    std::vector<CommonEntry>        _common;
+    std::vector<u32>                _added;
+    std::vector<u8>                 _isCommon;
+};
+}  // namespace hq
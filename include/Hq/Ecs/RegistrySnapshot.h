@@ -0,0 +1,187 @@
+#pragma once
+
+#include "entt/fwd.hpp"
+#include "entt/entity/entity.hpp"
+#include "entt/entity/registry.hpp"
+#include "Hq/BasicTypes.h"
+#include "Hq/BinarySerializer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace hq
+{
+/// Save states of the `Components` of a registry (rollback, replays, network snapshots).
+/// Each component pool is written as one block: the entities, then the components, in a single write when the
+/// component is trivially copyable or with its `Serialize(Serializer&)` method otherwise, empty (tag) components
+/// only write their entities.
+/// `restore` reads and checks every pool first, then clears the registry, recreates the entities with the same
+/// identifiers and inserts every pool in one batch: an invalid snapshot leaves the registry untouched.
+/// Keep the snapshot object around, its staging buffers are reused so a restore doesn't allocate per entity.
+/// @note entities owning none of `Components` are not saved. Like BinarySerializer, there is no versioning: a
+/// snapshot only restores with the same component list and layouts (sizes are checked).
+/// @example usage:
+///     RegistrySnapshot<Position, Velocity, SceneHierarchy> snapshot;
+///     snapshot.save(registry, stream);
+///     ...
+///     snapshot.restore(registry, stream);
+template <typename... Components>
+class RegistrySnapshot
+{
+public:
+    static constexpr u32 kSnapshotMagic   = 0x48515253;  // HQRS
+    static constexpr u32 kSnapshotVersion = 1;
+
+    void save(entt::registry& registry, std::ostream& out)
+    {
+        BinarySerializer serializer(out);
+        serializer(kSnapshotMagic);
+        serializer(kSnapshotVersion);
+        serializer(static_cast<u32>(sizeof...(Components)));
+        (savePool<Components>(registry, serializer), ...);
+    }
+
+    /// Returns false if the snapshot is invalid or was saved with other components, the registry is then unchanged
+    bool restore(entt::registry& registry, std::istream& in)
+    {
+        BinaryDeserializer deserializer(in);
+        u32                magic = 0, version = 0, count = 0;
+        deserializer(magic);
+        deserializer(version);
+        deserializer(count);
+        if (!in || magic != kSnapshotMagic || version != kSnapshotVersion || count != sizeof...(Components))
+            return false;
+
+        if (!(readPool<Components>(in, deserializer) && ...))
+            return false;
+
+        registry.clear();
+        (insertPool<Components>(registry), ...);
+        return true;
+    }
+
+private:
+    // elements read at once, a corrupted count fails at the end of the stream instead of allocating it
+    static constexpr size_t kReadChunkSize = 4096;
+
+    template <typename T>
+    struct Pool
+    {
+        std::vector<entt::entity> entities;
+        std::vector<T>            components;
+
+        void clear()
+        {
+            entities.clear();
+            components.clear();
+        }
+    };
+
+    template <typename T>
+    Pool<T>& staging()
+    {
+        return std::get<Pool<T>>(_pools);
+    }
+
+    template <typename T>
+    void savePool(entt::registry& registry, BinarySerializer& serializer)
+    {
+        Pool<T>& pool = staging<T>();
+        pool.clear();
+        for (entt::entity entity : registry.view<T>())
+        {
+            pool.entities.push_back(entity);
+            if constexpr (!std::is_empty_v<T>)
+                pool.components.push_back(registry.get<T>(entity));
+        }
+
+        serializer(static_cast<u32>(sizeof(T)));
+        serializer(static_cast<u64>(pool.entities.size()));
+        serializer.write(pool.entities.data(), pool.entities.size() * sizeof(entt::entity));
+        if constexpr (std::is_trivially_copyable_v<T>)
+            serializer.write(pool.components.data(), pool.components.size() * sizeof(T));
+        else
+        {
+            for (T& component : pool.components)
+                serializer(component);
+        }
+    }
+
+    template <typename T>
+    bool readPool(std::istream& in, BinaryDeserializer& deserializer)
+    {
+        u32 size  = 0;
+        u64 count = 0;
+        deserializer(size);
+        deserializer(count);
+        if (!in || size != sizeof(T))
+            return false;
+
+        Pool<T>& pool = staging<T>();
+        pool.clear();
+        while (pool.entities.size() < count)
+        {
+            const size_t offset = pool.entities.size();
+            const size_t chunk  = static_cast<size_t>(std::min<u64>(count - offset, kReadChunkSize));
+            pool.entities.resize(offset + chunk);
+            if (!deserializer.read(pool.entities.data() + offset, chunk * sizeof(entt::entity)))
+                return false;
+        }
+        for (entt::entity entity : pool.entities)
+        {
+            if (entity == entt::null)
+                return false;
+        }
+
+        if constexpr (!std::is_empty_v<T>)
+        {
+            while (pool.components.size() < count)
+            {
+                const size_t offset = pool.components.size();
+                const size_t chunk  = static_cast<size_t>(std::min<u64>(count - offset, kReadChunkSize));
+                pool.components.resize(offset + chunk);
+                if constexpr (std::is_trivially_copyable_v<T>)
+                {
+                    if (!deserializer.read(pool.components.data() + offset, chunk * sizeof(T)))
+                        return false;
+                }
+                else
+                {
+                    for (size_t i = offset; i < offset + chunk; ++i)
+                        deserializer(pool.components[i]);
+                    if (!in)
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    void insertPool(entt::registry& registry)
+    {
+        // entities shared by several pools are created by the first one
+        Pool<T>& pool = staging<T>();
+        for (entt::entity entity : pool.entities)
+        {
+            if (!registry.valid(entity))
+            {
+                const entt::entity created = registry.create(entity);
+                assert(created == entity);
+                (void)created;
+            }
+        }
+        if constexpr (std::is_empty_v<T>)
+            registry.insert<T>(pool.entities.begin(), pool.entities.end());
+        else
+            registry.insert<T>(pool.entities.begin(), pool.entities.end(), pool.components.begin());
+    }
+
+private:
+    std::tuple<Pool<Components>...> _pools;
+};
+}  // namespace hq
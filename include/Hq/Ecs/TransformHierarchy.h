@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/Ecs/FlatHierarchy.h"
+#include "Hq/Math/Mat4x4.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace hq
+{
+/// Transform relative to the parent, written by gameplay code through TransformHierarchy::setLocal
+struct LocalTransform
+{
+    math::Mat4x4 matrix {math::Mat4x4::Identity};
+
+    template <class Serializer>
+    void Serialize(Serializer& serializer)
+    {
+        SERIALIZE(matrix);
+    }
+};
+
+/// Transform in world space, written by TransformHierarchy::update
+struct WorldTransform
+{
+    math::Mat4x4 matrix {math::Mat4x4::Identity};
+
+    template <class Serializer>
+    void Serialize(Serializer& serializer)
+    {
+        SERIALIZE(matrix);
+    }
+};
+
+/// Keeps the WorldTransform of the entities of a hierarchy up to date from their LocalTransform.
+/// Only the subtrees of the entities changed since the last update are recomputed: changed entities are recorded
+/// as dirty and `update` walks each dirty subtree once in the depth-first order of a FlatHierarchy, a subtree
+/// already covered by a dirty ancestor is skipped. Siblings without children are consecutive in that order, their
+/// world matrices are computed in one batched multiply by their parent.
+/// Entities without LocalTransform use the identity.
+/// @example usage:
+///     TransformHierarchy<SceneHierarchy> transforms;
+///     transforms.build(registry);
+///     transforms.setLocal(registry, entity, matrix);  // every frame, only for the moving entities
+///     transforms.update(registry);
+template <typename HierarchicalComp>
+class TransformHierarchy
+{
+public:
+    /// Flattens the hierarchies of the registry and marks all of them dirty
+    void build(entt::registry& registry)
+    {
+        _hierarchy.build(registry);
+        _dirtyEntities.clear();
+        for (u32 i = 0; i < _hierarchy.size(); i += _hierarchy.subtreeSize(i))
+            _dirtyEntities.push_back(_hierarchy.entity(i));
+    }
+
+    void setLocal(entt::registry& registry, entt::entity entity, const math::Mat4x4& matrix)
+    {
+        registry.emplace_or_replace<LocalTransform>(entity, LocalTransform {matrix});
+        markDirty(entity);
+    }
+
+    void setLocal(entt::registry& registry, entt::entity entity, const math::Quat& rotation, const math::Vec3& scale,
+                  const math::Vec3& translation)
+    {
+        setLocal(registry, entity, math::Mat4x4(rotation, scale, translation));
+    }
+
+    /// Call it after changing the LocalTransform of an entity without `setLocal`
+    void markDirty(entt::entity entity)
+    {
+        _dirtyEntities.push_back(entity);
+    }
+
+    /// Structural changes, same contract as FlatHierarchy, the moved subtree is marked dirty
+    void add(entt::registry& registry, entt::entity entity)
+    {
+        _hierarchy.add(registry, entity);
+        markDirty(entity);
+    }
+
+    void reparent(entt::registry& registry, entt::entity entity)
+    {
+        _hierarchy.reparent(registry, entity);
+        markDirty(entity);
+    }
+
+    void remove(entt::entity entity)
+    {
+        _hierarchy.remove(entity);
+    }
+
+    bool isDirty() const
+    {
+        return !_dirtyEntities.empty();
+    }
+
+    /// Recomputes the world transforms of the dirty subtrees, returns the number of entities updated
+    u32 update(entt::registry& registry)
+    {
+        // flat indices change on structural changes, dirty entities are only resolved here
+        _dirtyRoots.clear();
+        for (entt::entity entity : _dirtyEntities)
+        {
+            if (_hierarchy.contains(entity))
+                _dirtyRoots.push_back(_hierarchy.indexOf(entity));
+        }
+        _dirtyEntities.clear();
+        if (_dirtyRoots.empty())
+            return 0;
+
+        // parents come first, a dirty root inside the subtree of a previous one is already covered
+        std::sort(_dirtyRoots.begin(), _dirtyRoots.end());
+        u32 updated = 0;
+        u32 end     = 0;
+        for (u32 root : _dirtyRoots)
+        {
+            if (root < end)
+                continue;
+            end = root + _hierarchy.subtreeSize(root);
+            updated += updateSubtree(registry, root);
+        }
+        return updated;
+    }
+
+    const FlatHierarchy<HierarchicalComp>& hierarchy() const
+    {
+        return _hierarchy;
+    }
+
+private:
+    u32 updateSubtree(entt::registry& registry, u32 root)
+    {
+        const u32 count = _hierarchy.subtreeSize(root);
+        _locals.resize(count);
+        _worlds.resize(count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            const LocalTransform* local = registry.try_get<LocalTransform>(_hierarchy.entity(root + i));
+            _locals[i]                  = local ? local->matrix : math::Mat4x4::Identity;
+        }
+
+        const u32 rootParent = _hierarchy.parent(root);
+        if (rootParent == FlatHierarchy<HierarchicalComp>::kNoParent)
+            _worlds[0] = _locals[0];
+        else
+        {
+            const WorldTransform* parentWorld = registry.try_get<WorldTransform>(_hierarchy.entity(rootParent));
+            math::mul(parentWorld ? parentWorld->matrix : math::Mat4x4::Identity, _locals[0], _worlds[0]);
+        }
+
+        // runs of consecutive entries with the same parent share the left operand
+        for (u32 i = 1; i < count;)
+        {
+            const u32 parent = _hierarchy.parent(root + i);
+            u32       run    = 1;
+            while (i + run < count && _hierarchy.parent(root + i + run) == parent)
+                ++run;
+            math::mul(_worlds[parent - root], &_locals[i], &_worlds[i], run);
+            i += run;
+        }
+
+        for (u32 i = 0; i < count; ++i)
+            registry.emplace_or_replace<WorldTransform>(_hierarchy.entity(root + i), WorldTransform {_worlds[i]});
+        return count;
+    }
+
+private:
+    FlatHierarchy<HierarchicalComp> _hierarchy;
+    std::vector<entt::entity>       _dirtyEntities;
+    // scratch of an update: dirty entities resolved to flat indices, then a subtree in depth-first order
+    std::vector<u32>                _dirtyRoots;
+    std::vector<math::Mat4x4>       _locals;
+    std::vector<math::Mat4x4>       _worlds;
+};
+}  // namespace hq
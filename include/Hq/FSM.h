@@ -1,10 +1,25 @@
 ﻿#pragma once
 
+#include "Hq/BasicTypes.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
 #include <tuple>
+#include <typeinfo>
+#include <utility>
 #include <variant>
-#include <optional>
-#include <unordered_map>
-#include <cassert>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
 
 namespace hq
 {
@@ -45,78 +60,450 @@ struct index_in_tuple
     static constexpr size_t value = index_in_tuple_fn<0, T, Tuple_t>();
 };
 
+/// Number of values of an enum used to index tables, `EnumClass::Count` by default (last enumerator).
+/// Specialize it for enums without a Count value.
+template <typename EnumClass>
+struct EnumCount
+{
+    static constexpr size_t value = static_cast<size_t>(EnumClass::Count);
+};
+
+/// Readable name of a type for profiles and logs, typeid names are mangled on GCC and Clang
+template <typename T>
+std::string typeName()
+{
+#if defined(__GNUG__)
+    int                                    status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status),
+                                                     std::free);
+    if (status == 0)
+        return demangled.get();
+#endif
+    return typeid(T).name();
+}
+
+/// Counters of a state, see FSMProfile
+struct FSMStateProfile
+{
+    std::string name;
+    u64         enterCount {0};
+    u64         tickCount {0};
+    double      tickTime {0.0};  // seconds spent in onTick
+
+    template <class Serializer>
+    void Serialize(Serializer& serializer)
+    {
+        SERIALIZE(name);
+        SERIALIZE(enterCount);
+        SERIALIZE(tickCount);
+        SERIALIZE(tickTime);
+    }
+};
+
+/// Instrumentation of a state machine, filled while attached with `setProfile`.
+/// States are indexed like the machine (stateIndex) and named after their type by default (see typeName), names
+/// already set when attaching are kept. Transitions are indexed by their enum value. Export it with any serializer, e.g. `JsonSerializer serializer(out); serializer(profile, "combat");`
+struct FSMProfile
+{
+    std::vector<FSMStateProfile> states;
+    std::vector<u64>             transitionCounts;
+
+    void reset()
+    {
+        for (FSMStateProfile& state : states)
+            state = FSMStateProfile {std::move(state.name)};
+        std::fill(transitionCounts.begin(), transitionCounts.end(), 0);
+    }
+
+    template <class Serializer>
+    void Serialize(Serializer& serializer)
+    {
+        SERIALIZE(states);
+        SERIALIZE(transitionCounts);
+    }
+};
+
 // got inspiration from here: https://sii.pl/blog/implementing-a-state-machine-in-c17/
+/// States, transition table and pushdown stack shared by FSM and SubMachine, the context is passed by the owner.
+/// States implement:
+///     std::optional<TransitionsEnumClass> onEnter(Context&);
+///     std::optional<TransitionsEnumClass> onTick(Context&);
+///     void onExit(Context&);
+/// A returned transition is looked up in a std::array indexed by the enum (see EnumCount), its entry is one of:
+/// - a state index (stateIndex): the current state is left and the new one entered
+/// - a push index (pushStateIndex): the current state is suspended on the stack, without onExit, and the new one
+///   entered
+/// - kPopState: the current state is left and the suspended one resumes, without onEnter
+/// - kNoState: the transition is not handled by this machine, a SubMachine passes it to its parent
+/// The stack holds kMaxStackDepth states, a push on a full stack or a pop on an empty one is refused (the current
+/// state stays) and counted in stackErrorCount, tables are data and can be wrong.
+/// States are set through a jump table, nothing is allocated or hashed when ticking.
 template <typename Context, typename TransitionsEnumClass, typename... States>
-class FSM
+class FSMCore
 {
 public:
+    static constexpr size_t kStateCount      = sizeof...(States);
+    static constexpr size_t kTransitionCount = EnumCount<TransitionsEnumClass>::value;
+    static constexpr size_t kMaxStackDepth   = 8;
+    static constexpr u8     kPushFlag        = 0x80;
+    static constexpr u8     kPopState        = 0xfe;
+    static constexpr u8     kNoState         = 0xff;
+
+    static_assert(kStateCount > 0 && kStateCount < kPushFlag, "FSM supports 1 to 127 states");
+
+    using TransitionType = TransitionsEnumClass;
+    using ResultType     = std::optional<TransitionsEnumClass>;
+
+    /// Entry of each transition, see FSMCore
+    using TransitionTable = std::array<u8, kTransitionCount>;
+
     template <typename State>
-    void changeState()
+    static constexpr size_t stateIndex()
+    {
+        return index_in_tuple<State, std::tuple<States...>>::value;
+    }
+
+    template <typename State>
+    static constexpr size_t pushStateIndex()
+    {
+        return stateIndex<State>() | kPushFlag;
+    }
+
+    static constexpr TransitionTable makeTransitionTable(
+        std::initializer_list<std::pair<TransitionsEnumClass, size_t>> transitions)
+    {
+        TransitionTable table {};
+        for (size_t i = 0; i < kTransitionCount; ++i)
+            table[i] = kNoState;
+        for (const auto& transition : transitions)
+            table[static_cast<size_t>(transition.first)] = static_cast<u8>(transition.second);
+        return table;
+    }
+
+    FSMCore()
+    {
+        mTransitions.fill(kNoState);
+    }
+
+    explicit FSMCore(const TransitionTable& transitions)
+        : mTransitions(transitions)
     {
-        std::optional<TransitionsEnumClass> stateTransition;
-        std::visit([this](auto statePtr) { statePtr->onExit(mContext); }, currentState);
-        currentState = &std::get<State>(states);
-        std::visit([this, &stateTransition](auto statePtr) { stateTransition = statePtr->onEnter(mContext); },
-                   currentState);
-        if (stateTransition)
+    }
+
+    template <typename State>
+    void addTransition(TransitionsEnumClass transition)
+    {
+        mTransitions[static_cast<size_t>(transition)] = static_cast<u8>(stateIndex<State>());
+    }
+
+    template <typename State>
+    void addPushTransition(TransitionsEnumClass transition)
+    {
+        mTransitions[static_cast<size_t>(transition)] = static_cast<u8>(pushStateIndex<State>());
+    }
+
+    void addPopTransition(TransitionsEnumClass transition)
+    {
+        mTransitions[static_cast<size_t>(transition)] = kPopState;
+    }
+
+    size_t currentStateIndex() const
+    {
+        return currentState.index();
+    }
+
+    template <typename State>
+    bool isInState() const
+    {
+        return std::holds_alternative<State*>(currentState);
+    }
+
+    /// Number of suspended states
+    size_t stackDepth() const
+    {
+        return mStackDepth;
+    }
+
+    /// Number of refused pushes (stack full) and pops (stack empty)
+    u32 stackErrorCount() const
+    {
+        return mStackErrors;
+    }
+
+    /// State instance, to configure a SubMachine for example
+    template <typename State>
+    State& state()
+    {
+        return std::get<State>(states);
+    }
+
+    /// Starts counting enters, ticks and transitions in `profile` (sized and named here), nullptr stops.
+    /// Only this machine is profiled, attach a profile to each SubMachine to look inside them.
+    void setProfile(FSMProfile* profile)
+    {
+        mProfile = profile;
+        if (!mProfile)
+            return;
+
+        const std::string names[] = {typeName<States>()...};
+        mProfile->states.resize(kStateCount);
+        mProfile->transitionCounts.resize(kTransitionCount, 0);
+        for (size_t i = 0; i < kStateCount; ++i)
         {
-            std::cout << "Transition\n";
-            changeState(*stateTransition);
+            if (mProfile->states[i].name.empty())
+                mProfile->states[i].name = names[i];
         }
     }
 
-    void tick()
+    FSMProfile* profile() const
+    {
+        return mProfile;
+    }
+
+protected:
+    // enters the first state with an empty stack
+    ResultType enterFirst(Context& context)
     {
-        std::optional<TransitionsEnumClass> stateTransition;
-        std::visit([this, &stateTransition](auto statePtr) { stateTransition = statePtr->onTick(mContext); },
-                   currentState);
-        if (stateTransition)
+        mStackDepth                 = 0;
+        const ResultType transition = enterState(0, context);
+        return transition ? follow(*transition, context) : std::nullopt;
+    }
+
+    // ticks the current state, returns the transition this machine doesn't handle
+    ResultType tickState(Context& context)
+    {
+        ResultType transition;
+        if (mProfile)
+        {
+            const size_t index = currentState.index();
+            const auto   start = std::chrono::steady_clock::now();
+            transition = std::visit([&context](auto statePtr) { return statePtr->onTick(context); }, currentState);
+            FSMStateProfile& stateProfile = mProfile->states[index];
+            ++stateProfile.tickCount;
+            stateProfile.tickTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        else
         {
-            std::cout << "Transition\n";
-            changeState(*stateTransition);
+            transition = std::visit([&context](auto statePtr) { return statePtr->onTick(context); }, currentState);
         }
+        return transition ? follow(*transition, context) : std::nullopt;
     }
 
-    template <typename State>
-    void addTransition(TransitionsEnumClass transition)
+    // leaves the current state and every suspended one
+    void exitAll(Context& context)
     {
-        mTransitionToIndex.emplace(std::make_pair(transition, index_in_tuple<State, decltype(states)>::value));
+        std::visit([&context](auto statePtr) { statePtr->onExit(context); }, currentState);
+        while (mStackDepth)
+        {
+            setState(mStack[--mStackDepth], std::index_sequence_for<States...> {});
+            std::visit([&context](auto statePtr) { statePtr->onExit(context); }, currentState);
+        }
     }
 
-private:
-    void changeState(TransitionsEnumClass transition)
-    {
-        std::optional<TransitionsEnumClass> stateTransition;
-        std::visit([this](auto statePtr) { statePtr->onExit(mContext); }, currentState);
-        assert(mTransitionToIndex.find(transition) != mTransitionToIndex.end());
-        changeState(mTransitionToIndex[transition]);
-        std::visit([this, &stateTransition](auto statePtr) { stateTransition = statePtr->onEnter(mContext); },
-                   currentState);
-        if (stateTransition)
+    ResultType changeState(size_t index, Context& context)
+    {
+        std::visit([&context](auto statePtr) { statePtr->onExit(context); }, currentState);
+        const ResultType transition = enterState(index, context);
+        return transition ? follow(*transition, context) : std::nullopt;
+    }
+
+    ResultType pushState(size_t index, Context& context)
+    {
+        const ResultType transition = suspendAndEnter(index, context);
+        return transition ? follow(*transition, context) : std::nullopt;
+    }
+
+    void popState(Context& context)
+    {
+        if (mStackDepth == 0)
         {
-            std::cout << "Transition\n";
-            assert(mTransitionToIndex.find(*stateTransition) != mTransitionToIndex.end());
-            changeState(mTransitionToIndex[*stateTransition]);
+            ++mStackErrors;
+            return;
         }
+        std::visit([&context](auto statePtr) { statePtr->onExit(context); }, currentState);
+        setState(mStack[--mStackDepth], std::index_sequence_for<States...> {});
     }
 
-    void changeState(size_t index)
+private:
+    // applies `transition` and the ones returned by onEnter, stops at the first one without entry
+    ResultType follow(TransitionsEnumClass transition, Context& context)
     {
-        size_t currentIndex = 0;
-        for_each(states, [this, index, &currentIndex](auto&& value) {
-            if (currentIndex == index)
+        while (true)
+        {
+            const size_t index = static_cast<size_t>(transition);
+            assert(index < kTransitionCount);
+            const u8 target = mTransitions[index];
+            if (target == kNoState)
+                return transition;
+            if (mProfile)
+                ++mProfile->transitionCounts[index];
+
+            ResultType next;
+            if (target == kPopState)
+            {
+                popState(context);
+                return std::nullopt;
+            }
+            else if (target & kPushFlag)
+            {
+                next = suspendAndEnter(target & ~kPushFlag, context);
+            }
+            else
             {
-                currentState = &value;
+                std::visit([&context](auto statePtr) { statePtr->onExit(context); }, currentState);
+                next = enterState(target, context);
             }
-            ++currentIndex;
-        });
+
+            if (!next)
+                return std::nullopt;
+            transition = *next;
+        }
+    }
+
+    ResultType suspendAndEnter(size_t index, Context& context)
+    {
+        if (mStackDepth == kMaxStackDepth)
+        {
+            ++mStackErrors;
+            return std::nullopt;
+        }
+        mStack[mStackDepth++] = static_cast<u8>(currentState.index());
+        return enterState(index, context);
+    }
+
+    ResultType enterState(size_t index, Context& context)
+    {
+        setState(index, std::index_sequence_for<States...> {});
+        if (mProfile)
+            ++mProfile->states[index].enterCount;
+        return std::visit([&context](auto statePtr) { return statePtr->onEnter(context); }, currentState);
+    }
+
+    template <size_t I>
+    static void setStateAt(FSMCore& fsm)
+    {
+        fsm.currentState.template emplace<I>(&std::get<I>(fsm.states));
+    }
+
+    template <size_t... I>
+    void setState(size_t index, std::index_sequence<I...>)
+    {
+        using Setter                     = void (*)(FSMCore&);
+        static constexpr Setter setters[] = {&FSMCore::setStateAt<I>...};
+        assert(index < kStateCount);
+        setters[index](*this);
+    }
+
+private:
+    std::tuple<States...>          states;
+    std::variant<States*...>       currentState {&std::get<0>(states)};
+    TransitionTable                mTransitions;
+    std::array<u8, kMaxStackDepth> mStack {};
+    u8                             mStackDepth {0};
+    u32                            mStackErrors {0};
+    FSMProfile*                    mProfile {nullptr};
+};
+
+/// Finite state machine owning its context, see FSMCore for the states and the transition table.
+/// It starts in the first state, without calling its onEnter. A transition without entry in the table is an error.
+/// The table can be built at compile time and shared by all the machines of the same type:
+///     using AiFSM = FSM<AiContext, AiTransition, Idle, Chase, Attack, Stunned>;
+///     constexpr AiFSM::TransitionTable kAiTransitions = AiFSM::makeTransitionTable(
+///         {{AiTransition::SeeEnemy, AiFSM::stateIndex<Chase>()}, {AiTransition::InRange, AiFSM::stateIndex<Attack>()},
+///          {AiTransition::Hit, AiFSM::pushStateIndex<Stunned>()}, {AiTransition::Recovered, AiFSM::kPopState}});
+///     AiFSM fsm(kAiTransitions);
+template <typename Context, typename TransitionsEnumClass, typename... States>
+class FSM : public FSMCore<Context, TransitionsEnumClass, States...>
+{
+    using Core = FSMCore<Context, TransitionsEnumClass, States...>;
+
+public:
+    FSM() = default;
+
+    explicit FSM(const typename Core::TransitionTable& transitions)
+        : Core(transitions)
+    {
+    }
+
+    template <typename State>
+    void changeState()
+    {
+        check(Core::changeState(Core::template stateIndex<State>(), mContext));
+    }
+
+    /// Suspends the current state and enters `State`, popState resumes the suspended one
+    template <typename State>
+    void pushState()
+    {
+        check(Core::pushState(Core::template stateIndex<State>(), mContext));
+    }
+
+    void popState()
+    {
+        Core::popState(mContext);
+    }
+
+    void tick()
+    {
+        check(Core::tickState(mContext));
+    }
+
+    Context& context()
+    {
+        return mContext;
+    }
+
+    const Context& context() const
+    {
+        return mContext;
     }
 
 private:
-    Context                                          mContext;
-    std::tuple<States...>                            states;
-    std::variant<States*...>                         currentState {&std::get<0>(states)};
-    std::unordered_map<TransitionsEnumClass, size_t> mTransitionToIndex;
+    static void check(const typename Core::ResultType& unhandled)
+    {
+        assert(!unhandled && "transition not registered");
+        (void)unhandled;
+    }
+
+private:
+    Context mContext;
+};
+
+/// State of a FSM (or of another SubMachine) running its own states on the parent context.
+/// Entering it enters its first state, leaving it leaves its current and suspended states. Transitions it has no
+/// entry for are returned to the parent, so shared ones (Die, LostEnemy...) are registered once at the top.
+/// Derive from it to name the state and give its table:
+///     struct Combat : SubMachine<AiContext, AiTransition, Approach, Strike>
+///     {
+///         Combat() : SubMachine(kCombatTransitions) {}
+///     };
+template <typename Context, typename TransitionsEnumClass, typename... States>
+class SubMachine : public FSMCore<Context, TransitionsEnumClass, States...>
+{
+    using Core = FSMCore<Context, TransitionsEnumClass, States...>;
+
+public:
+    SubMachine() = default;
+
+    explicit SubMachine(const typename Core::TransitionTable& transitions)
+        : Core(transitions)
+    {
+    }
+
+    std::optional<TransitionsEnumClass> onEnter(Context& context)
+    {
+        return Core::enterFirst(context);
+    }
+
+    std::optional<TransitionsEnumClass> onTick(Context& context)
+    {
+        return Core::tickState(context);
+    }
+
+    void onExit(Context& context)
+    {
+        Core::exitAll(context);
+    }
 };
 
 }  // hq namespace
@@ -0,0 +1,874 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/Bits.h"
+#include "Hq/Handle.h"
+#include "Hq/StringHash.h"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HQ_FLAT_HASH_SSE2 1
+#include <emmintrin.h>
+#else
+#define HQ_FLAT_HASH_SSE2 0
+#endif
+
+namespace hq
+{
+/// Hash used by FlatHashMap/FlatHashSet. Keys that already are hashes (StringHash) or unique ids (handles) are
+/// returned as is, the table spreads them with a single multiply instead of hashing them again.
+template <typename Key>
+struct FlatHash
+{
+    size_t operator()(const Key& key) const
+    {
+        return std::hash<Key>()(key);
+    }
+};
+
+template <>
+struct FlatHash<StringHash>
+{
+    size_t operator()(const StringHash& key) const
+    {
+        return key.hash();
+    }
+};
+
+template <size_t StorageBits, size_t GenerationBits>
+struct FlatHash<Handle<StorageBits, GenerationBits>>
+{
+    size_t operator()(const Handle<StorageBits, GenerationBits>& key) const
+    {
+        return static_cast<uint32_t>(key);
+    }
+};
+
+template <size_t IndexBits, size_t GenerationBits, size_t TypeBits>
+struct FlatHash<Handle64<IndexBits, GenerationBits, TypeBits>>
+{
+    size_t operator()(const Handle64<IndexBits, GenerationBits, TypeBits>& key) const
+    {
+        return static_cast<size_t>(static_cast<uint64_t>(key));
+    }
+};
+
+namespace detail
+{
+// control byte of a slot: empty, deleted (tombstone) or the 7 low bits of the hash of a full slot
+using ctrl_t                     = i8;
+static const ctrl_t kCtrlEmpty   = -128;
+static const ctrl_t kCtrlDeleted = -2;
+static const u32    kGroupWidth  = 16;
+
+struct alignas(16) CtrlGroup
+{
+    ctrl_t bytes[kGroupWidth];
+};
+
+// bitmasks of the slots of a group matching a condition, bit i is slot i
+class GroupMatch
+{
+public:
+    explicit GroupMatch(const CtrlGroup& group)
+#if HQ_FLAT_HASH_SSE2
+        : _ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(group.bytes)))
+#else
+        : _group(group)
+#endif
+    {
+    }
+
+    u32 match(ctrl_t h2) const
+    {
+#if HQ_FLAT_HASH_SSE2
+        return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)));
+#else
+        u32 mask = 0;
+        for (u32 i = 0; i < kGroupWidth; ++i)
+            mask |= u32(_group.bytes[i] == h2) << i;
+        return mask;
+#endif
+    }
+
+    u32 matchEmpty() const
+    {
+        return match(kCtrlEmpty);
+    }
+
+    // empty and deleted are the only negative control bytes
+    u32 matchEmptyOrDeleted() const
+    {
+#if HQ_FLAT_HASH_SSE2
+        return static_cast<u32>(_mm_movemask_epi8(_ctrl));
+#else
+        u32 mask = 0;
+        for (u32 i = 0; i < kGroupWidth; ++i)
+            mask |= u32(_group.bytes[i] < 0) << i;
+        return mask;
+#endif
+    }
+
+private:
+#if HQ_FLAT_HASH_SSE2
+    __m128i _ctrl;
+#else
+    CtrlGroup _group;
+#endif
+};
+
+/// Open addressing table shared by FlatHashMap and FlatHashSet (Swiss table layout).
+/// Slots are split in groups of 16, each slot has a control byte so a whole group is probed with one SIMD compare.
+/// Groups are probed quadratically until a group with an empty slot, max load factor is 7/8.
+/// @tparam Policy gives the key of a slot: `static const Key& key(const Slot&)`
+template <typename Key, typename Slot, typename Policy, typename Hash, typename KeyEqual, typename Alloc>
+class FlatTable
+{
+    using SlotAlloc       = typename std::allocator_traits<Alloc>::template rebind_alloc<Slot>;
+    using SlotTraits      = std::allocator_traits<SlotAlloc>;
+    using CtrlAlloc       = typename std::allocator_traits<Alloc>::template rebind_alloc<CtrlGroup>;
+    using CtrlTraits      = std::allocator_traits<CtrlAlloc>;
+    static const u32 kMinGroups = 2;
+
+public:
+    template <bool Const>
+    class Iterator
+    {
+    public:
+        using Table             = std::conditional_t<Const, const FlatTable, FlatTable>;
+        using value_type        = Slot;
+        using reference         = std::conditional_t<Const, const Slot&, Slot&>;
+        using pointer           = std::conditional_t<Const, const Slot*, Slot*>;
+        using difference_type   = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        Iterator() = default;
+
+        Iterator(Table* table, size_t index)
+            : _table(table)
+            , _index(index)
+        {
+            skipFree();
+        }
+
+        // iterator to const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other)
+            : _table(other._table)
+            , _index(other._index)
+        {
+        }
+
+        reference operator*() const
+        {
+            return _table->_slots[_index];
+        }
+
+        pointer operator->() const
+        {
+            return &_table->_slots[_index];
+        }
+
+        Iterator& operator++()
+        {
+            ++_index;
+            skipFree();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator it = *this;
+            ++(*this);
+            return it;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return _index == other._index;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return _index != other._index;
+        }
+
+    private:
+        friend class FlatTable;
+        friend class Iterator<true>;
+
+        void skipFree()
+        {
+            while (_index < _table->_capacity && _table->ctrl(_index) < 0)
+                ++_index;
+        }
+
+        Table* _table {nullptr};
+        size_t _index {0};
+    };
+
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatTable(const Alloc& alloc)
+        : _alloc(alloc)
+    {
+    }
+
+    FlatTable(const FlatTable& other)
+        : _hash(other._hash)
+        , _equal(other._equal)
+        , _alloc(other._alloc)
+    {
+        reserve(other._size);
+        for (const Slot& slot : other)
+            insertUnique(Slot(slot));
+    }
+
+    FlatTable(FlatTable&& other) noexcept
+        : _hash(std::move(other._hash))
+        , _equal(std::move(other._equal))
+        , _alloc(other._alloc)
+    {
+        swapStorage(other);
+    }
+
+    FlatTable& operator=(const FlatTable& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other._size);
+            for (const Slot& slot : other)
+                insertUnique(Slot(slot));
+        }
+        return *this;
+    }
+
+    FlatTable& operator=(FlatTable&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _hash  = std::move(other._hash);
+            _equal = std::move(other._equal);
+            _alloc = other._alloc;
+            swapStorage(other);
+        }
+        return *this;
+    }
+
+    ~FlatTable()
+    {
+        release();
+    }
+
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(this, _capacity);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, _capacity);
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    /// Destroys all the elements, keeps the memory
+    void clear()
+    {
+        for (size_t i = 0; i < _capacity; ++i)
+        {
+            if (ctrl(i) >= 0)
+                SlotTraits::destroy(_alloc, &_slots[i]);
+        }
+        if (_capacity)
+            std::memset(_ctrl, kCtrlEmpty, _capacity);
+        _size       = 0;
+        _growthLeft = maxLoad(_capacity);
+    }
+
+    /// Makes room for `count` elements without rehashing
+    void reserve(size_t count)
+    {
+        if (count > maxLoad(_capacity))
+            rehash(capacityFor(count));
+    }
+
+    template <typename K>
+    iterator find(const K& key)
+    {
+        return iterator(this, findIndex(key));
+    }
+
+    template <typename K>
+    const_iterator find(const K& key) const
+    {
+        return const_iterator(this, findIndex(key));
+    }
+
+    template <typename K>
+    bool contains(const K& key) const
+    {
+        return findIndex(key) != _capacity;
+    }
+
+    template <typename K>
+    size_t count(const K& key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    /// Returns the slot of `key` and true when it was just inserted, `construct(void*)` builds the new slot
+    template <typename K, typename F>
+    std::pair<iterator, bool> findOrInsert(const K& key, F&& construct)
+    {
+        const u64 hash  = mix(key);
+        size_t    index = findIndex(key, hash);
+        if (index != _capacity)
+            return {iterator(this, index), false};
+
+        index = prepareInsert(hash);
+        construct(static_cast<void*>(&_slots[index]));
+        return {iterator(this, index), true};
+    }
+
+    template <typename K>
+    size_t erase(const K& key)
+    {
+        const size_t index = findIndex(key);
+        if (index == _capacity)
+            return 0;
+
+        eraseAt(index);
+        return 1;
+    }
+
+    iterator erase(const_iterator it)
+    {
+        eraseAt(it._index);
+        return iterator(this, it._index + 1);
+    }
+
+private:
+    static size_t maxLoad(size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    static size_t capacityFor(size_t count)
+    {
+        size_t capacity = kMinGroups * kGroupWidth;
+        while (maxLoad(capacity) < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    ctrl_t ctrl(size_t index) const
+    {
+        return _ctrl[index / kGroupWidth].bytes[index % kGroupWidth];
+    }
+
+    void setCtrl(size_t index, ctrl_t value)
+    {
+        _ctrl[index / kGroupWidth].bytes[index % kGroupWidth] = value;
+    }
+
+    template <typename K>
+    u64 mix(const K& key) const
+    {
+        // fibonacci hashing, high bits pick the group and low bits go in the control byte
+        return static_cast<u64>(_hash(key)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    static ctrl_t h2(u64 hash)
+    {
+        return static_cast<ctrl_t>(hash & 0x7f);
+    }
+
+    size_t firstGroup(u64 hash) const
+    {
+        return static_cast<size_t>(hash >> _shift);
+    }
+
+    template <typename K>
+    size_t findIndex(const K& key) const
+    {
+        return _capacity ? findIndex(key, mix(key)) : 0;
+    }
+
+    template <typename K>
+    size_t findIndex(const K& key, u64 hash) const
+    {
+        if (_capacity == 0)
+            return 0;
+
+        const size_t groupMask = _capacity / kGroupWidth - 1;
+        size_t       group     = firstGroup(hash);
+        for (size_t probe = 1;; ++probe)
+        {
+            const GroupMatch match(_ctrl[group]);
+            for (u32 mask = match.match(h2(hash)); mask; mask &= mask - 1)
+            {
+                const size_t index = group * kGroupWidth + countTrailingZeros(mask);
+                if (_equal(Policy::key(_slots[index]), key))
+                    return index;
+            }
+            if (match.matchEmpty())
+                return _capacity;
+
+            // triangular numbers visit every group when the group count is a power of two
+            group = (group + probe) & groupMask;
+        }
+    }
+
+    size_t findFreeSlot(u64 hash) const
+    {
+        const size_t groupMask = _capacity / kGroupWidth - 1;
+        size_t       group     = firstGroup(hash);
+        for (size_t probe = 1;; ++probe)
+        {
+            const u32 mask = GroupMatch(_ctrl[group]).matchEmptyOrDeleted();
+            if (mask)
+                return group * kGroupWidth + countTrailingZeros(mask);
+
+            group = (group + probe) & groupMask;
+        }
+    }
+
+    size_t prepareInsert(u64 hash)
+    {
+        if (_capacity == 0)
+            rehash(capacityFor(1));
+
+        size_t index = findFreeSlot(hash);
+        if (_growthLeft == 0 && ctrl(index) == kCtrlEmpty)
+        {
+            // grow when the table is more than half full, otherwise only get rid of the tombstones
+            rehash(_size * 2 >= maxLoad(_capacity) ? _capacity * 2 : _capacity);
+            index = findFreeSlot(hash);
+        }
+
+        if (ctrl(index) == kCtrlEmpty)
+            --_growthLeft;
+        setCtrl(index, h2(hash));
+        ++_size;
+        return index;
+    }
+
+    void insertUnique(Slot&& slot)
+    {
+        const size_t index = prepareInsert(mix(Policy::key(slot)));
+        SlotTraits::construct(_alloc, &_slots[index], std::move(slot));
+    }
+
+    void eraseAt(size_t index)
+    {
+        assert(index < _capacity && ctrl(index) >= 0);
+        SlotTraits::destroy(_alloc, &_slots[index]);
+        --_size;
+
+        // probing never went past a group that still has an empty slot, so this slot can become empty again
+        if (GroupMatch(_ctrl[index / kGroupWidth]).matchEmpty())
+        {
+            setCtrl(index, kCtrlEmpty);
+            ++_growthLeft;
+        }
+        else
+            setCtrl(index, kCtrlDeleted);
+    }
+
+    void rehash(size_t capacity)
+    {
+        assert(capacity >= kMinGroups * kGroupWidth && (capacity & (capacity - 1)) == 0);
+
+        CtrlGroup* oldCtrl     = _ctrl;
+        Slot*      oldSlots    = _slots;
+        size_t     oldCapacity = _capacity;
+
+        CtrlAlloc ctrlAlloc(_alloc);
+        _ctrl     = CtrlTraits::allocate(ctrlAlloc, capacity / kGroupWidth);
+        _slots    = SlotTraits::allocate(_alloc, capacity);
+        _capacity = capacity;
+        std::memset(_ctrl, kCtrlEmpty, capacity);
+        _size       = 0;
+        _growthLeft = maxLoad(capacity);
+
+        u32 groupBits = 0;
+        while ((size_t(1) << groupBits) < capacity / kGroupWidth)
+            ++groupBits;
+        _shift = 64 - groupBits;
+
+        for (size_t i = 0; i < oldCapacity; ++i)
+        {
+            const ctrl_t c = oldCtrl[i / kGroupWidth].bytes[i % kGroupWidth];
+            if (c >= 0)
+            {
+                insertUnique(std::move(oldSlots[i]));
+                SlotTraits::destroy(_alloc, &oldSlots[i]);
+            }
+        }
+
+        if (oldCapacity)
+        {
+            CtrlTraits::deallocate(ctrlAlloc, oldCtrl, oldCapacity / kGroupWidth);
+            SlotTraits::deallocate(_alloc, oldSlots, oldCapacity);
+        }
+    }
+
+    void release()
+    {
+        if (_capacity == 0)
+            return;
+
+        clear();
+        CtrlAlloc ctrlAlloc(_alloc);
+        CtrlTraits::deallocate(ctrlAlloc, _ctrl, _capacity / kGroupWidth);
+        SlotTraits::deallocate(_alloc, _slots, _capacity);
+        _ctrl       = nullptr;
+        _slots      = nullptr;
+        _capacity   = 0;
+        _growthLeft = 0;
+    }
+
+    void swapStorage(FlatTable& other)
+    {
+        std::swap(_ctrl, other._ctrl);
+        std::swap(_slots, other._slots);
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+        std::swap(_growthLeft, other._growthLeft);
+        std::swap(_shift, other._shift);
+    }
+
+private:
+    Hash       _hash;
+    KeyEqual   _equal;
+    SlotAlloc  _alloc;
+    CtrlGroup* _ctrl {nullptr};
+    Slot*      _slots {nullptr};
+    size_t     _capacity {0};
+    size_t     _size {0};
+    // inserts left before rehashing, deleted slots don't give room back
+    size_t     _growthLeft {0};
+    u32        _shift {64};
+};
+
+template <typename Key, typename T>
+struct FlatMapPolicy
+{
+    static const Key& key(const std::pair<Key, T>& slot)
+    {
+        return slot.first;
+    }
+};
+
+template <typename Key>
+struct FlatSetPolicy
+{
+    static const Key& key(const Key& slot)
+    {
+        return slot;
+    }
+};
+}  // namespace detail
+
+/// Open addressing hash map for hot lookups (resources, reflection registries...), see detail::FlatTable.
+/// Elements are stored inline, so references and iterators are invalidated by any insertion.
+/// Keys must not be modified through iterators.
+/// @example usage:
+///     FlatHashMap<StringHash, ResourceHandle> resources;
+///     resources["player.mesh"_sh] = handle;
+///     auto it = resources.find("player.mesh"_sh);
+///     // in an arena
+///     FlatHashMap<StringHash, u32, FlatHash<StringHash>, std::equal_to<StringHash>,
+///                 StdAllocatorAdapter<std::pair<StringHash, u32>>> map(StdAllocatorAdapter<u8>(arena));
+/// @tparam Hash hash of the keys, FlatHash doesn't rehash StringHash and handles
+/// @tparam Alloc std compatible allocator, StdAllocatorAdapter to use one of our allocators
+template <typename Key, typename T, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename Alloc = std::allocator<std::pair<Key, T>>>
+class FlatHashMap
+{
+    using Table = detail::FlatTable<Key, std::pair<Key, T>, detail::FlatMapPolicy<Key, T>, Hash, KeyEqual, Alloc>;
+
+public:
+    using key_type       = Key;
+    using mapped_type    = T;
+    using value_type     = std::pair<Key, T>;
+    using iterator       = typename Table::iterator;
+    using const_iterator = typename Table::const_iterator;
+
+    FlatHashMap()
+        : _table(Alloc())
+    {
+    }
+
+    explicit FlatHashMap(const Alloc& alloc)
+        : _table(alloc)
+    {
+    }
+
+    iterator begin()
+    {
+        return _table.begin();
+    }
+
+    iterator end()
+    {
+        return _table.end();
+    }
+
+    const_iterator begin() const
+    {
+        return _table.begin();
+    }
+
+    const_iterator end() const
+    {
+        return _table.end();
+    }
+
+    size_t size() const
+    {
+        return _table.size();
+    }
+
+    bool empty() const
+    {
+        return _table.empty();
+    }
+
+    size_t capacity() const
+    {
+        return _table.capacity();
+    }
+
+    void clear()
+    {
+        _table.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        _table.reserve(count);
+    }
+
+    iterator find(const Key& key)
+    {
+        return _table.find(key);
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        return _table.find(key);
+    }
+
+    bool contains(const Key& key) const
+    {
+        return _table.contains(key);
+    }
+
+    size_t count(const Key& key) const
+    {
+        return _table.count(key);
+    }
+
+    /// Inserts `T(args...)` if `key` is missing, doesn't touch args otherwise
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return _table.findOrInsert(key, [&](void* p) {
+            new (p) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const Key& key, Args&&... args)
+    {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value)
+    {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second)
+            result.first->second = std::forward<M>(value);
+        return result;
+    }
+
+    T& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    T& at(const Key& key)
+    {
+        auto it = find(key);
+        assert(it != end());
+        return it->second;
+    }
+
+    const T& at(const Key& key) const
+    {
+        auto it = find(key);
+        assert(it != end());
+        return it->second;
+    }
+
+    size_t erase(const Key& key)
+    {
+        return _table.erase(key);
+    }
+
+    iterator erase(const_iterator it)
+    {
+        return _table.erase(it);
+    }
+
+private:
+    Table _table;
+};
+
+/// Set version of FlatHashMap
+template <typename Key, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename Alloc = std::allocator<Key>>
+class FlatHashSet
+{
+    using Table = detail::FlatTable<Key, Key, detail::FlatSetPolicy<Key>, Hash, KeyEqual, Alloc>;
+
+public:
+    using key_type       = Key;
+    using value_type     = Key;
+    using iterator       = typename Table::const_iterator;
+    using const_iterator = typename Table::const_iterator;
+
+    FlatHashSet()
+        : _table(Alloc())
+    {
+    }
+
+    explicit FlatHashSet(const Alloc& alloc)
+        : _table(alloc)
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return _table.begin();
+    }
+
+    const_iterator end() const
+    {
+        return _table.end();
+    }
+
+    size_t size() const
+    {
+        return _table.size();
+    }
+
+    bool empty() const
+    {
+        return _table.empty();
+    }
+
+    size_t capacity() const
+    {
+        return _table.capacity();
+    }
+
+    void clear()
+    {
+        _table.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        _table.reserve(count);
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        return _table.find(key);
+    }
+
+    bool contains(const Key& key) const
+    {
+        return _table.contains(key);
+    }
+
+    size_t count(const Key& key) const
+    {
+        return _table.count(key);
+    }
+
+    std::pair<const_iterator, bool> insert(const Key& key)
+    {
+        auto result = _table.findOrInsert(key, [&](void* p) { new (p) Key(key); });
+        return {result.first, result.second};
+    }
+
+    template <typename... Args>
+    std::pair<const_iterator, bool> emplace(Args&&... args)
+    {
+        return insert(Key(std::forward<Args>(args)...));
+    }
+
+    size_t erase(const Key& key)
+    {
+        return _table.erase(key);
+    }
+
+    const_iterator erase(const_iterator it)
+    {
+        return _table.erase(it);
+    }
+
+private:
+    Table _table;
+};
+}  // namespace hq
@@ -1,14 +1,24 @@
 #pragma once
 
-#include "Hq/Types.h"
+#include "Hq/BasicTypes.h"
 #include "Hq/Handle.h"
+#include "Hq/JobManager.h"
+#include "Hq/Span.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
 
 namespace hq
 {
+/// Number of packed objects processed by one job in `forEachParallel`
+static const size_t kFreeListParallelBatchSize = 1024;
+
 template <typename T, bool IsPOD = true>
 struct FreelistConstructor
 {
@@ -103,6 +113,25 @@ struct FreeList
         _freeHead = handle.index();
     }
 
+    /// Allocates up to `count` handles in one go, returns how many were allocated
+    size_t allocN(H* outHandles, size_t count)
+    {
+        size_t allocated = 0;
+        while (allocated < count && _freeHead < StorageSize)
+        {
+            const u32 index         = _freeHead;
+            _freeHead               = _freeList[index].index();
+            outHandles[allocated++] = H(index, _freeList[index].generation());
+        }
+        return allocated;
+    }
+
+    void removeN(Span<const H> handles)
+    {
+        for (const H& handle : handles)
+            remove(handle);
+    }
+
     T* get(const H& handle)
     {
         return const_cast<T*>(static_cast<const FreeList*>(this)->get(handle));
@@ -130,6 +159,63 @@ public:
     T        _storage[StorageSize];
 };
 
+namespace detail
+{
+    /// Batches smaller than count / kSortedCompactionRatio are compacted by sorting, bigger ones by a linear sweep
+    static const u32 kSortedCompactionRatio = 32;
+
+    /// Removes the packed locations in `released` (unique) from a packed array by moving surviving objects from the
+    /// end into the holes. The linear sweep moves each surviving object at most once, the sorted path moves an object
+    /// again when the hole it filled later becomes the last location. Free list entries of moved objects are updated.
+    /// Locations [returned count, count) are left moved-from, callers reset or drop them.
+    template <typename T, typename H>
+    u32 compactPackedStorage(T* array, u32* indices, H* freeList, u32 count, std::vector<u32>& released,
+                             std::vector<u8>& marks)
+    {
+        const u32 newCount = count - static_cast<u32>(released.size());
+
+        if (released.size() * kSortedCompactionRatio < count)
+        {
+            // release from the back to the front, this way the last object is never one waiting to be released
+            std::sort(released.begin(), released.end(), std::greater<u32>());
+            u32 lastIndex = count;
+            for (u32 releasedIndex : released)
+            {
+                if (releasedIndex != --lastIndex)
+                {
+                    array[releasedIndex]   = std::move(array[lastIndex]);
+                    indices[releasedIndex] = indices[lastIndex];
+                    freeList[indices[releasedIndex]].setIndex(releasedIndex);
+                }
+            }
+        }
+        else
+        {
+            // holes in [0, newCount) are exactly as many as the survivors in [newCount, count)
+            marks.assign(count, 0);
+            for (u32 releasedIndex : released)
+                marks[releasedIndex] = 1;
+
+            u32 source = newCount;
+            for (u32 hole = 0; hole < newCount; ++hole)
+            {
+                if (!marks[hole])
+                    continue;
+
+                while (marks[source])
+                    ++source;
+
+                array[hole]   = std::move(array[source]);
+                indices[hole] = indices[source];
+                freeList[indices[hole]].setIndex(hole);
+                ++source;
+            }
+        }
+
+        return newCount;
+    }
+}  // namespace detail
+
 /// Similar with FreeList but it keeps a cache friendly packed array that can be iterated over
 template <typename T, typename H, size_t StorageSize, bool IsPOD>
 struct PackedFreeList
@@ -236,6 +322,80 @@ struct PackedFreeList
         _freeHead = handle.index();
     }
 
+    /// Allocates up to `count` handles in one go, returns how many were allocated.
+    /// New objects are appended at the end of the packed array in handle order.
+    size_t allocN(H* outHandles, size_t count)
+    {
+        size_t allocated       = 0;
+        u32    storageLocation = _storage.count;
+        while (allocated < count && _freeHead < StorageSize)
+        {
+            const u32 freeIndex = _freeHead;
+            _freeHead           = _freeList[freeIndex].index();
+            _freeList[freeIndex].setIndex(storageLocation);
+            _storage.indices[storageLocation++] = freeIndex;
+            outHandles[allocated++]             = H(freeIndex, _freeList[freeIndex].generation());
+        }
+        _storage.count = storageLocation;
+        return allocated;
+    }
+
+    /// Removes a batch of handles, invalid and duplicated handles are ignored.
+    /// Released objects are compacted in one pass (see detail::compactPackedStorage).
+    void removeN(Span<const H> handles)
+    {
+        _releasedIndices.clear();
+
+        for (const H& handle : handles)
+        {
+            if (!isValid(handle))
+                continue;
+
+            _releasedIndices.push_back(_freeList[handle.index()].index());
+
+            _freeList[handle.index()].setGeneration(_freeList[handle.index()].generation() + 1);
+            if (_freeList[handle.index()].generation() == 0)
+                _freeList[handle.index()].setGeneration(1);
+
+            _freeList[handle.index()].setIndex(_freeHead);
+            _freeHead = handle.index();
+        }
+
+        const u32 newCount = detail::compactPackedStorage(_storage.array, _storage.indices, _freeList, _storage.count,
+                                                          _releasedIndices, _releasedMarks);
+
+        // reconstruct objects, so they're clean the next time we use them
+        for (u32 i = newCount; i < _storage.count; ++i)
+        {
+            FreelistConstructor<T, IsPOD>::destruct(&_storage.array[i]);
+            FreelistConstructor<T, IsPOD>::construct(&_storage.array[i]);
+        }
+        _storage.count = newCount;
+    }
+
+    /// Calls `func(T&)` for every packed object
+    template <typename F>
+    void forEach(F&& func)
+    {
+        for (u32 i = 0; i < _storage.count; ++i)
+            func(_storage.array[i]);
+    }
+
+    /// Calls `func(T&)` for every packed object from the job manager workers, returns when all objects are processed.
+    /// `func` must be safe to call concurrently for different objects.
+    template <typename F>
+    void forEachParallel(JobManager& jobManager, F&& func)
+    {
+        jobManager.parallel_for<T, CountSplitter<T, kFreeListParallelBatchSize>>(
+            [&func](void* data, size_t count) {
+                T* objects = static_cast<T*>(data);
+                for (size_t i = 0; i < count; ++i)
+                    func(objects[i]);
+            },
+            _storage.array, _storage.count);
+        jobManager.wait();
+    }
+
     T* get(const H& handle)
     {
         return const_cast<T*>(static_cast<const PackedFreeList*>(this)->get(handle));
@@ -293,6 +453,9 @@ private:
     u32      _freeHead;
     H             _freeList[StorageSize];
     PackedStorage _storage;
+    // scratch buffers for removeN, kept to avoid allocating on every batch
+    std::vector<u32> _releasedIndices;
+    std::vector<u8>  _releasedMarks;
 };
 
 }  // atlas namespace
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Hq/Allocator.h"
+
+/// Debug allocator that maps every allocation on its own pages, flush against a protected guard page, so that
+/// writing past the end of a block faults immediately. Freed blocks are poisoned, protected and kept in a
+/// quarantine for a while, so that a use-after-free faults as well instead of silently corrupting a neighbour.
+/// When built with AddressSanitizer the freed blocks are also poisoned through the ASan manual poisoning API.
+/// @note Each allocation costs at least two pages of address space, use it for soak tests, not for shipping.
+/// @example usage, swap it in place of a pool or freelist allocator:
+///     Allocator* allocator = allocator::newGuardedAllocator(size, mainAllocator);
+///     // Allocator* allocator = allocator::newFreeListAllocator(size, mainAllocator);
+class GuardedAllocator : public Allocator
+{
+public:
+    static const u8     kPoisonByte            = 0xDD;
+    static const size_t kDefaultQuarantineSize = 64;
+
+    /// @param size maximum amount of user memory that can be handed out, same meaning as for the other allocators
+    /// @param quarantineSize number of freed blocks kept protected before their pages are returned to the system
+    GuardedAllocator(size_t size, size_t quarantineSize = kDefaultQuarantineSize);
+    ~GuardedAllocator();
+
+    void* allocate(size_t size, u8 alignment) override;
+
+    void deallocate(void* p) override;
+
+    /// Number of freed blocks currently held protected in the quarantine
+    size_t getQuarantinedCount() const;
+
+private:
+    struct AllocationHeader
+    {
+        u32    magic;
+        void*  base;
+        size_t mappedSize;
+        size_t size;
+    };
+
+    GuardedAllocator(const GuardedAllocator&);  // Prevent copies because it might cause errors
+    GuardedAllocator& operator=(const GuardedAllocator&);
+
+    size_t            _pageSize;
+    size_t            _quarantineSize;
+    size_t            _quarantineHead;
+    AllocationHeader* _quarantine;
+};
+
+namespace allocator
+{
+inline GuardedAllocator* newGuardedAllocator(size_t size, Allocator& allocator,
+                                             size_t quarantineSize = GuardedAllocator::kDefaultQuarantineSize)
+{
+    // Only the allocator object lives in the parent allocator, the guarded blocks are mapped from the system
+    void* p = allocator.allocate(sizeof(GuardedAllocator), __alignof(GuardedAllocator));
+    return new (p) GuardedAllocator(size, quarantineSize);
+}
+
+inline void deleteGuardedAllocator(GuardedAllocator& guardedAllocator, Allocator& allocator)
+{
+    guardedAllocator.~GuardedAllocator();
+
+    allocator.deallocate(&guardedAllocator);
+}
+}  // allocator namespace
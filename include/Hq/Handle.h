@@ -26,6 +26,8 @@ struct Handle
     {
     }
 
+    Handle& operator=(const Handle<StorageBits, GenerationBits>& other) = default;
+
     Handle(uint32_t index, uint32_t generation)
         : _index(index)
         , _generation(generation)
@@ -191,4 +193,143 @@ inline void TypedHandle<I, G, T>::setType(uint32_t type)
 }
 
 #pragma pack(pop)
+
+/// 64 bit handle for containers that need more than ~1M live objects or long lived handles under heavy churn.
+/// Fields are extracted with constexpr masks and shifts rather than bitfields, layout from the low bits is
+/// [index][generation][type]. Has the same interface as Handle so it can be used with every FreeList container.
+/// @tparam IndexBits bits of the storage index, at most 32
+/// @tparam GenerationBits bits of the generation, at most 32
+/// @tparam TypeBits bits of an optional user type, 0 for untyped handles
+template <size_t IndexBits, size_t GenerationBits, size_t TypeBits = 0>
+struct Handle64
+{
+    static_assert(IndexBits > 0 && IndexBits <= 32, "index must fit in 32 bits");
+    static_assert(GenerationBits > 0 && GenerationBits <= 32, "generation must fit in 32 bits");
+    static_assert(IndexBits + GenerationBits + TypeBits <= 64, "handle doesn't fit in 64 bits");
+
+    static constexpr uint64_t IndexShift      = 0;
+    static constexpr uint64_t GenerationShift = IndexBits;
+    static constexpr uint64_t TypeShift       = IndexBits + GenerationBits;
+    static constexpr uint64_t IndexMask       = ((uint64_t(1) << IndexBits) - 1) << IndexShift;
+    static constexpr uint64_t GenerationMask  = ((uint64_t(1) << GenerationBits) - 1) << GenerationShift;
+    static constexpr uint64_t TypeMask        = TypeBits ? ((uint64_t(1) << TypeBits) - 1) << TypeShift : 0;
+    static constexpr uint32_t MaxIndex        = static_cast<uint32_t>(IndexMask >> IndexShift);
+    static constexpr uint32_t MaxType         = static_cast<uint32_t>(TypeMask >> TypeShift);
+
+    static const Handle64 invalid;
+
+    constexpr Handle64()
+        : _handle(0)
+    {
+    }
+
+    Handle64(uint32_t index, uint32_t generation)
+        : _handle((uint64_t(index) << IndexShift) | ((uint64_t(generation) << GenerationShift) & GenerationMask))
+    {
+        assert(index <= MaxIndex);
+    }
+
+    Handle64(uint32_t index, uint32_t generation, uint32_t type)
+        : Handle64(index, generation)
+    {
+        static_assert(TypeBits > 0, "handle has no type bits");
+        assert(type <= MaxType);
+        _handle |= uint64_t(type) << TypeShift;
+    }
+
+    uint32_t index() const;
+    uint32_t generation() const;
+    uint32_t type() const;
+    void     setIndex(uint32_t index);
+    void     setGeneration(uint32_t generation);
+    void     setType(uint32_t type);
+    bool     operator!=(const Handle64& other) const;
+    bool     operator==(const Handle64& other) const;
+    bool     operator<(const Handle64& other) const;
+    bool     valid() const;
+             operator uint64_t() const
+    {
+        return _handle;
+    }
+
+private:
+    uint64_t _handle;
+};
+
+template <size_t I, size_t G, size_t T>
+const Handle64<I, G, T> Handle64<I, G, T>::invalid;
+
+template <size_t I, size_t G, size_t T>
+inline uint32_t Handle64<I, G, T>::index() const
+{
+    return static_cast<uint32_t>((_handle & IndexMask) >> IndexShift);
+}
+
+template <size_t I, size_t G, size_t T>
+inline uint32_t Handle64<I, G, T>::generation() const
+{
+    return static_cast<uint32_t>((_handle & GenerationMask) >> GenerationShift);
+}
+
+template <size_t I, size_t G, size_t T>
+inline uint32_t Handle64<I, G, T>::type() const
+{
+    static_assert(T > 0, "handle has no type bits");
+    return static_cast<uint32_t>((_handle & TypeMask) >> TypeShift);
+}
+
+template <size_t I, size_t G, size_t T>
+inline void Handle64<I, G, T>::setIndex(uint32_t index)
+{
+    assert(index <= MaxIndex);
+    _handle = (_handle & ~IndexMask) | (uint64_t(index) << IndexShift);
+}
+
+template <size_t I, size_t G, size_t T>
+inline void Handle64<I, G, T>::setGeneration(uint32_t generation)
+{
+    // wraps around like the bitfield version, containers map 0 back to 1
+    _handle = (_handle & ~GenerationMask) | ((uint64_t(generation) << GenerationShift) & GenerationMask);
+}
+
+template <size_t I, size_t G, size_t T>
+inline void Handle64<I, G, T>::setType(uint32_t type)
+{
+    static_assert(T > 0, "handle has no type bits");
+    assert(type <= MaxType);
+    _handle = (_handle & ~TypeMask) | (uint64_t(type) << TypeShift);
+}
+
+template <size_t I, size_t G, size_t T>
+inline bool Handle64<I, G, T>::operator!=(const Handle64& other) const
+{
+    return _handle != other._handle;
+}
+
+template <size_t I, size_t G, size_t T>
+inline bool Handle64<I, G, T>::operator==(const Handle64& other) const
+{
+    return _handle == other._handle;
+}
+
+template <size_t I, size_t G, size_t T>
+inline bool Handle64<I, G, T>::operator<(const Handle64& other) const
+{
+    // same ordering as Handle: by index then generation, type breaks the remaining ties
+    const uint64_t lhs = ((_handle & IndexMask) << 32) | ((_handle & GenerationMask) >> GenerationShift);
+    const uint64_t rhs = ((other._handle & IndexMask) << 32) | ((other._handle & GenerationMask) >> GenerationShift);
+    if (lhs != rhs)
+        return lhs < rhs;
+
+    return (_handle & TypeMask) < (other._handle & TypeMask);
+}
+
+template <size_t I, size_t G, size_t T>
+inline bool Handle64<I, G, T>::valid() const
+{
+    return *this != Handle64<I, G, T>::invalid;
+}
+
+template <size_t StorageBits, size_t GenerationBits, size_t TypeBits>
+using TypedHandle64 = Handle64<StorageBits, GenerationBits, TypeBits>;
 }  // atlas namespace
@@ -1,80 +1,106 @@
 #pragma once
 
+#include "Hq/BasicTypes.h"
+#include "Hq/CompileHash.h"
+#include "Hq/StringHash.h"
+
+#include <cstring>
 #include <functional>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 namespace hq
 {
+namespace hash
+{
+    static const u64 kSecret0 = 0xa0761d6478bd642full;
+    static const u64 kSecret1 = 0xe7037ed1a0b428dbull;
+    static const u64 kSecret2 = 0x8ebc6af09c88c6e3ull;
+
+    /// wyhash mum mixer: 64x64 -> 128 bits multiply folded back to 64 bits, every input bit reaches every output bit
+    inline u64 mix(u64 a, u64 b)
+    {
+#if defined(__SIZEOF_INT128__)
+        const __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<u64>(r) ^ static_cast<u64>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        u64 high;
+        const u64 low = _umul128(a, b, &high);
+        return low ^ high;
+#else
+        return compile::wymix(a, b);
+#endif
+    }
+
+    /// Raw 64 bit value of a key, no hashing: integers, enums and pointers as is, floats by bits, StringHash by hash
+    template <typename T>
+    inline u64 value(const T& v)
+    {
+        if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+            return static_cast<u64>(v);
+        else if constexpr (std::is_pointer_v<T>)
+            return static_cast<u64>(reinterpret_cast<uptr>(v));
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            // +0 and -0 compare equal so they must hash the same
+            if (v == T(0))
+                return 0;
+            u64 bits = 0;
+            memcpy(&bits, &v, sizeof(T));
+            return bits;
+        }
+        else if constexpr (std::is_same_v<T, StringHash>)
+            return v.hash();
+        else
+            return static_cast<u64>(std::hash<T>()(v));
+    }
+}  // namespace hash
+
+/// Folds the value of `v` into `seed`, one multiply per value
 template <class T>
 inline void hash_combine(std::size_t& seed, const T& v)
 {
-    std::hash<T> hasher;
-    seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed = static_cast<size_t>(hash::mix(static_cast<u64>(seed) ^ hash::kSecret1, hash::value(v) ^ hash::kSecret2));
 }
 
-template <typename T1>
-inline size_t make_hash(T1 t1)
+/// Hash of several values (grid coordinates, keys made of ids...) for hash maps, all bits of the result are well
+/// mixed so it can be used directly by open addressing tables.
+/// @example size_t h = make_hash(cell.x, cell.y, layer);
+template <typename... Ts>
+inline size_t make_hash(const Ts&... values)
 {
-    return std::hash<T1>(t1);
-}
+    static_assert(sizeof...(Ts) > 0, "make_hash needs at least one value");
 
-template <typename T1, typename T2>
-inline size_t make_hash(T1 t1, T2 t2)
-{
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    return seed;
-}
+    constexpr size_t count          = sizeof...(Ts);
+    const u64        inputs[count] = {hash::value(values)...};
 
-template <typename T1, typename T2, typename T3>
-inline size_t make_hash(T1 t1, T2 t2, T3 t3)
-{
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    hash_combine(seed, std::hash<T3>()(t3));
-    return seed;
-}
+    // values go through the multiply two at a time, like the wyhash main loop
+    u64    h = hash::kSecret0;
+    size_t i = 0;
+    for (; i + 1 < count; i += 2)
+        h = hash::mix(inputs[i] ^ hash::kSecret1, inputs[i + 1] ^ h);
+    if (i < count)
+        h = hash::mix(inputs[i] ^ hash::kSecret1, hash::kSecret2 ^ h);
 
-template <typename T1, typename T2, typename T3, typename T4>
-inline size_t make_hash(T1 t1, T2 t2, T3 t3, T4 t4)
-{
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    hash_combine(seed, std::hash<T3>()(t3));
-    hash_combine(seed, std::hash<T4>()(t4));
-    return seed;
+    // last round so every input bit reaches every output bit
+    return static_cast<size_t>(hash::mix(h ^ hash::kSecret0, count ^ hash::kSecret2));
 }
 
-template <typename T1, typename T2, typename T3, typename T4, typename T5>
-inline size_t make_hash(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5)
+/// Hash of raw memory
+inline size_t hash_bytes(const void* data, size_t size, u64 seed = 0)
 {
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    hash_combine(seed, std::hash<T3>()(t3));
-    hash_combine(seed, std::hash<T4>()(t4));
-    hash_combine(seed, std::hash<T5>()(t5));
-    return seed;
+    return static_cast<size_t>(WyHash64(data, size, seed));
 }
-template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6>
-inline size_t make_hash(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6)
-{
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    hash_combine(seed, std::hash<T3>()(t3));
-    hash_combine(seed, std::hash<T4>()(t4));
-    hash_combine(seed, std::hash<T5>()(t5));
-    hash_combine(seed, std::hash<T6>()(t6));
-    return seed;
-}
-template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7>
-inline size_t make_hash(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7)
+
+/// Hash of the bytes of a trivially copyable struct.
+/// @note padding bytes are hashed too, zero them (or avoid padding) so equal structs hash the same
+template <typename T, typename = std::enable_if_t<!std::is_pointer_v<T>>>
+inline size_t hash_bytes(const T& value, u64 seed = 0)
 {
-    size_t seed = std::hash<T1>()(t1);
-    hash_combine(seed, std::hash<T2>()(t2));
-    hash_combine(seed, std::hash<T3>()(t3));
-    hash_combine(seed, std::hash<T4>()(t4));
-    hash_combine(seed, std::hash<T5>()(t5));
-    hash_combine(seed, std::hash<T6>()(t6));
-    hash_combine(seed, std::hash<T7>()(t7));
-    return seed;
-}
+    static_assert(std::is_trivially_copyable_v<T>, "hash_bytes needs a trivially copyable type");
+    return hash_bytes(&value, sizeof(T), seed);
 }
+}  // namespace hq
@@ -1,9 +1,11 @@
 #pragma once
 #include "Hq/BasicTypes.h"
+#include "Hq/Bits.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
-#include <set>
+#include <vector>
 
 namespace hq
 {
@@ -13,62 +15,196 @@ struct Interval
     u32 right;  // not inclusive
 };
 
-bool operator<(const Interval& lhs, const Interval& rhs)
-{
-    return lhs.left < rhs.left && lhs.right < rhs.right;
-}
-
+/// Gives unique ids in [1, max u32), always the smallest free one, 0 means no id is available.
+/// Free ids are tracked by a hierarchical bitmap: each bit of a level tells if the matching 64 bit word of the level
+/// below has a free id, so getId/freeId are O(log64 n) with no allocation besides growing the bitmap.
 class IdPool
 {
 public:
-    IdPool()
+    static const u32 kDefaultCapacity = 4096;
+
+    explicit IdPool(u32 initialCapacity = kDefaultCapacity)
     {
-        _free.insert({1, std::numeric_limits<u32>::max()});
+        _levels.resize(1);
+        _levels[0].resize((std::max<u64>(initialCapacity, kWordBits) + kWordBits - 1) / kWordBits, ~u64(0));
+        // 0 is the invalid id
+        _levels[0][0] &= ~u64(1);
+        _capacity = _levels[0].size() * kWordBits;
+        buildLevels();
     }
 
     u32 getId()
     {
-        Interval first = *(_free.begin());
-        u32      id    = first.left;
-        _free.erase(_free.begin());
-        if (first.left + 1 < first.right)
-            _free.insert({first.left + 1, first.right});
-        return id < std::numeric_limits<u32>::max() ? id : 0;
+        u64 id = findFirstFree();
+        if (id == kNone && grow())
+            id = findFirstFree();
+
+        if (id == kNone)
+            return 0;
+
+        markUsed(id);
+        return static_cast<u32>(id);
+    }
+
+    /// Gets `count` ids as a few contiguous ranges, smallest ids first.
+    /// Ranges are appended to `ranges`, less than `count` ids are given if the pool runs out.
+    void getIds(u32 count, std::vector<Interval>& ranges)
+    {
+        while (count > 0)
+        {
+            u64 id = findFirstFree();
+            if (id == kNone && grow())
+                id = findFirstFree();
+
+            if (id == kNone)
+                return;
+
+            // take the run of free ids starting at `id`, a word at a time
+            const u64 first = id;
+            while (count > 0 && id < _capacity)
+            {
+                u64&      word  = _levels[0][id / kWordBits];
+                const u32 bit   = id % kWordBits;
+                const u64 freed = ~(word >> bit);
+                u32       run   = freed == 0 ? kWordBits - bit : countTrailingZeros(freed);
+                if (run == 0)
+                    break;
+                if (run > count)
+                    run = count;
+
+                const u64 mask = (run == kWordBits ? ~u64(0) : ((u64(1) << run) - 1)) << bit;
+                word &= ~mask;
+                if (word == 0)
+                    propagateUsed(id / kWordBits);
+
+                id += run;
+                count -= run;
+                if (bit + run < kWordBits)
+                    break;
+            }
+
+            if (!ranges.empty() && ranges.back().right == first)
+                ranges.back().right = static_cast<u32>(id);
+            else
+                ranges.push_back({static_cast<u32>(first), static_cast<u32>(id)});
+        }
     }
+
     void freeId(u32 id)
     {
-        if (id == 0 || id == std::numeric_limits<u32>::max())
+        if (id == 0 || id == std::numeric_limits<u32>::max() || id >= _capacity)
             return;
 
-        Interval interval {id, id + 1};
-        auto     it = _free.find(interval);
-        if (it != _free.end())
+        u64&      word = _levels[0][id / kWordBits];
+        const u64 bit  = u64(1) << (id % kWordBits);
+        // already free
+        if (word & bit)
             return;
 
-        it = _free.upper_bound(interval);
-        if (it == _free.end())
-            return;
-        else
-        {
-            Interval freeInterval = *(it);
+        const bool wasFull = word == 0;
+        word |= bit;
+        if (wasFull)
+            propagateFree(id / kWordBits);
+    }
 
-            assert(freeInterval.left >= interval.right);
+    void freeIds(const Interval& range)
+    {
+        for (u32 id = range.left; id < range.right; ++id)
+            freeId(id);
+    }
 
-            if (interval.right < freeInterval.left)
-            {
-                _free.insert(interval);
+    bool isUsed(u32 id) const
+    {
+        return id == 0 || id >= _capacity || !(_levels[0][id / kWordBits] & (u64(1) << (id % kWordBits)));
+    }
+
+private:
+    static constexpr u32 kWordBits = 64;
+    static constexpr u64 kNone     = ~u64(0);
+    static constexpr u64 kMaxIds   = u64(1) << 32;
+
+    u64 findFirstFree() const
+    {
+        if (_levels.back()[0] == 0)
+            return kNone;
+
+        // descend from the single top word, following the first non empty child at each level
+        u64 index = 0;
+        for (size_t level = _levels.size(); level-- > 0;)
+            index = index * kWordBits + countTrailingZeros(_levels[level][index]);
+
+        return index;
+    }
+
+    void markUsed(u64 id)
+    {
+        u64& word = _levels[0][id / kWordBits];
+        word &= ~(u64(1) << (id % kWordBits));
+        if (word == 0)
+            propagateUsed(id / kWordBits);
+    }
+
+    // word `index` of level 0 just became full, clear its bit in the levels above
+    void propagateUsed(u64 index)
+    {
+        for (size_t level = 1; level < _levels.size(); ++level)
+        {
+            u64& word = _levels[level][index / kWordBits];
+            word &= ~(u64(1) << (index % kWordBits));
+            if (word != 0)
                 return;
-            }
+            index /= kWordBits;
+        }
+    }
+
+    // word `index` of level 0 just got its first free bit, set its bit in the levels above
+    void propagateFree(u64 index)
+    {
+        for (size_t level = 1; level < _levels.size(); ++level)
+        {
+            u64&       word    = _levels[level][index / kWordBits];
+            const bool wasFull = word == 0;
+            word |= u64(1) << (index % kWordBits);
+            if (!wasFull)
+                return;
+            index /= kWordBits;
+        }
+    }
 
-            if (interval.right == freeInterval.left)
+    bool grow()
+    {
+        if (_capacity >= kMaxIds)
+            return false;
+
+        const u64 capacity = _capacity * 2 < kMaxIds ? _capacity * 2 : kMaxIds;
+        _levels[0].resize(capacity / kWordBits, ~u64(0));
+        // max u32 is not a valid id either
+        if (capacity == kMaxIds)
+            _levels[0].back() &= ~(u64(1) << (kWordBits - 1));
+        _capacity = capacity;
+        buildLevels();
+        return true;
+    }
+
+    void buildLevels()
+    {
+        _levels.resize(1);
+        while (_levels.back().size() > 1)
+        {
+            const std::vector<u64>& children = _levels.back();
+            std::vector<u64>        parents((children.size() + kWordBits - 1) / kWordBits, 0);
+            for (size_t i = 0; i < children.size(); ++i)
             {
-                _free.erase(it);
-                _free.insert({interval.left, freeInterval.right});
+                if (children[i] != 0)
+                    parents[i / kWordBits] |= u64(1) << (i % kWordBits);
             }
+            _levels.push_back(std::move(parents));
         }
     }
 
 private:
-    std::set<Interval> _free;
+    // _levels[0] has a bit per id, set when the id is free, the last level is a single word
+    std::vector<std::vector<u64>> _levels;
+    u64                           _capacity {0};
 };
 }  // namespace hq
@@ -94,7 +94,7 @@ void JobManager::addJob(FuncType func, DataType* data, size_t count)
         DataType* castData = static_cast<DataType*>(jobData);
         func(castData, jobCount);
     };
-    addJob(jobFunc, static_cast<void*>(data), count);
+    addJob(JobFunc(jobFunc), static_cast<void*>(data), count);
 }
 
 template<typename FuncType, typename DataType>
@@ -104,7 +104,7 @@ void JobManager::addSignalingJob(FuncType func, DataType *data, size_t count, Jo
         DataType* castData = static_cast<DataType*>(jobData);
         func(castData, jobCount);
     };
-    addSignalingJob(jobFunc, static_cast<void*>(data), count, callback);
+    addSignalingJob(JobFunc(jobFunc), static_cast<void*>(data), count, callback);
 }
 
 template <typename DataType, typename SplitterType>
@@ -119,7 +119,7 @@ void JobManager::parallel_for(JobFunc func, void* data, size_t count)
             parallel_for<DataType, SplitterType>(func, castData, leftCount);
             parallel_for<DataType, SplitterType>(func, castData + leftCount, rightCount);
         };
-        addJob(jobFunc, data, count);
+        addJob(JobFunc(jobFunc), data, count);
     }
     else
     {
@@ -12,7 +12,11 @@ namespace math
     bool  isIdentity(const Mat4x4& matrix);
     void  setIdentity(Mat4x4& dst);
     void  mul(const Mat4x4& matrix, float scalar, Mat4x4& dst);
+    /// dst can be lhs or rhs
     void  mul(const Mat4x4& lhs, const Mat4x4& rhs, Mat4x4& dst);
+    /// dst[i] = lhs * rhs[i] for `count` matrices, lhs is loaded once for the whole batch (children of a node...),
+    /// dst can be rhs
+    void  mul(const Mat4x4& lhs, const Mat4x4* rhs, Mat4x4* dst, size_t count);
     void  mul(Mat4x4& lhs, const Mat4x4& rhs);
     void  createLookAt(const Vec3& eyePosition, const Vec3& targetPosition, const Vec3& up, Mat4x4& dst);
     void  createLookAt(float eyePositionX, float eyePositionY, float eyePositionZ, float targetCenterX,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <stddef.h>
 #include "Hq/BasicTypes.h"
 
@@ -36,8 +37,16 @@ namespace math
         {
         }
 
-        float&       operator[](size_t i);
-        const float& operator[](size_t i) const;
+        float& operator[](size_t i)
+        {
+            assert(i < 2);
+            return data[i];
+        }
+        const float& operator[](size_t i) const
+        {
+            assert(i < 2);
+            return data[i];
+        }
 
         static const Vec2 Zero;
         static const Vec2 One;
@@ -85,8 +94,16 @@ namespace math
         {
         }
 
-        int&       operator[](size_t i);
-        const int& operator[](size_t i) const;
+        int& operator[](size_t i)
+        {
+            assert(i < 2);
+            return data[i];
+        }
+        const int& operator[](size_t i) const
+        {
+            assert(i < 2);
+            return data[i];
+        }
 
         static const Vec2i Zero;
         static const Vec2i One;
@@ -141,8 +158,16 @@ namespace math
         {
         }
 
-        float&       operator[](size_t i);
-        const float& operator[](size_t i) const;
+        float& operator[](size_t i)
+        {
+            assert(i < 3);
+            return data[i];
+        }
+        const float& operator[](size_t i) const
+        {
+            assert(i < 3);
+            return data[i];
+        }
 
         static const Vec3 Zero;
         static const Vec3 One;
@@ -206,8 +231,16 @@ namespace math
         {
         }
 
-        float&       operator[](size_t i);
-        const float& operator[](size_t i) const;
+        float& operator[](size_t i)
+        {
+            assert(i < 4);
+            return data[i];
+        }
+        const float& operator[](size_t i) const
+        {
+            assert(i < 4);
+            return data[i];
+        }
 
         static const Vec4 Zero;
         static const Vec4 One;
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "MathTypes.h"
 
 namespace hq
@@ -6,40 +8,40 @@ namespace math
 {
     ///////////////////////// Vec2 /////////////////////////
 
-    bool isZero(const Vec2& v);
-    bool isOne(const Vec2& v);
-    Vec2 operator-(const Vec2& v);
-    Vec2 operator+(const Vec2& lhs, const Vec2& rhs);
-    void add(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
-    Vec2 operator-(const Vec2& lhs, const Vec2& rhs);
-    void sub(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
-    Vec2 operator*(const Vec2& lhs, const Vec2& rhs);
-    void mul(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
-    Vec2 operator*(float f, const Vec2& v);
-    Vec2 operator*(const Vec2& v, float f);
-    void mul(float f, const Vec2& v, Vec2& dst);
-    void mul(const Vec2& v, float f, Vec2& dst);
-    Vec2 operator/(const Vec2& lhs, const Vec2& rhs);
-    void div(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
-
-    float angle(const Vec2& v1, const Vec2& v2);
-    Vec2  clamp(const Vec2& v, const Vec2& min, const Vec2& max);
-    void  clamp(const Vec2& v, const Vec2& min, const Vec2& max, Vec2& dst);
-    void  clamp(Vec2& v, const Vec2& min, const Vec2& max);
-    float dot(const Vec2& v1, const Vec2& v2);
-    float length(const Vec2& v);
-    float lengthSquared(const Vec2& v);
-    float distance(const Vec2& v1, const Vec2& v2);
-    float distanceSquared(const Vec2& v1, const Vec2& v2);
-    Vec2  normalize(const Vec2& v);
-    void  normalize(const Vec2& v, Vec2& dst);
-    void  normalize(Vec2& v);
-    Vec2  scale(const Vec2& v, float scale);
-    void  scale(const Vec2& v, float scale, Vec2& dst);
-    void  scale(Vec2& v, float scale);
-    Vec2  rotate(const Vec2& v, const Vec2& point, float angle);
-    void  rotate(const Vec2& v, const Vec2& point, float angle, Vec2& dst);
-    void  rotate(Vec2& v, const Vec2& point, float angle);
+    constexpr bool isZero(const Vec2& v);
+    constexpr bool isOne(const Vec2& v);
+    constexpr Vec2 operator-(const Vec2& v);
+    constexpr Vec2 operator+(const Vec2& lhs, const Vec2& rhs);
+    constexpr void add(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
+    constexpr Vec2 operator-(const Vec2& lhs, const Vec2& rhs);
+    constexpr void sub(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
+    constexpr Vec2 operator*(const Vec2& lhs, const Vec2& rhs);
+    constexpr void mul(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
+    constexpr Vec2 operator*(float f, const Vec2& v);
+    constexpr Vec2 operator*(const Vec2& v, float f);
+    constexpr void mul(float f, const Vec2& v, Vec2& dst);
+    constexpr void mul(const Vec2& v, float f, Vec2& dst);
+    constexpr Vec2 operator/(const Vec2& lhs, const Vec2& rhs);
+    constexpr void div(const Vec2& lhs, const Vec2& rhs, Vec2& dst);
+
+    float           angle(const Vec2& v1, const Vec2& v2);
+    Vec2            clamp(const Vec2& v, const Vec2& min, const Vec2& max);
+    void            clamp(const Vec2& v, const Vec2& min, const Vec2& max, Vec2& dst);
+    void            clamp(Vec2& v, const Vec2& min, const Vec2& max);
+    constexpr float dot(const Vec2& v1, const Vec2& v2);
+    float           length(const Vec2& v);
+    constexpr float lengthSquared(const Vec2& v);
+    float           distance(const Vec2& v1, const Vec2& v2);
+    constexpr float distanceSquared(const Vec2& v1, const Vec2& v2);
+    Vec2            normalize(const Vec2& v);
+    void            normalize(const Vec2& v, Vec2& dst);
+    void            normalize(Vec2& v);
+    constexpr Vec2  scale(const Vec2& v, float scale);
+    constexpr void  scale(const Vec2& v, float scale, Vec2& dst);
+    constexpr void  scale(Vec2& v, float scale);
+    Vec2            rotate(const Vec2& v, const Vec2& point, float angle);
+    void            rotate(const Vec2& v, const Vec2& point, float angle, Vec2& dst);
+    void            rotate(Vec2& v, const Vec2& point, float angle);
 
     Vec2 minVec(const Vec2& v1, const Vec2& v2);
     Vec2 maxVec(const Vec2& v1, const Vec2& v2);
@@ -76,5 +78,121 @@ namespace math
     int maxComponent(const Vec2i& v);
     int minComponent(const Vec2i& v);
     int meanComponent(const Vec2i& v);
+
+    inline constexpr bool isZero(const Vec2& v)
+    {
+        return v.x == 0.f && v.y == 0.f;
+    }
+
+    inline constexpr bool isOne(const Vec2& v)
+    {
+        return v.x == 1.f && v.y == 1.f;
+    }
+
+    inline constexpr Vec2 operator-(const Vec2& v)
+    {
+        return Vec2(-v.x, -v.y);
+    }
+
+    inline constexpr Vec2 operator+(const Vec2& lhs, const Vec2& rhs)
+    {
+        return Vec2(lhs.x + rhs.x, lhs.y + rhs.y);
+    }
+
+    inline constexpr void add(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
+    {
+        dst.x = lhs.x + rhs.x;
+        dst.y = lhs.y + rhs.y;
+    }
+
+    inline constexpr Vec2 operator-(const Vec2& lhs, const Vec2& rhs)
+    {
+        return Vec2(lhs.x - rhs.x, lhs.y - rhs.y);
+    }
+
+    inline constexpr void sub(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
+    {
+        dst.x = lhs.x - rhs.x;
+        dst.y = lhs.y - rhs.y;
+    }
+
+    inline constexpr Vec2 operator*(const Vec2& lhs, const Vec2& rhs)
+    {
+        return Vec2(lhs.x * rhs.x, lhs.y * rhs.y);
+    }
+
+    inline constexpr void mul(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
+    {
+        dst.x = lhs.x * rhs.x;
+        dst.y = lhs.y * rhs.y;
+    }
+
+    inline constexpr Vec2 operator*(float f, const Vec2& v)
+    {
+        return Vec2(f * v.x, f * v.y);
+    }
+
+    inline constexpr Vec2 operator*(const Vec2& v, float f)
+    {
+        return Vec2(f * v.x, f * v.y);
+    }
+
+    inline constexpr void mul(float f, const Vec2& v, Vec2& dst)
+    {
+        dst.x = f * v.x;
+        dst.y = f * v.y;
+    }
+
+    inline constexpr void mul(const Vec2& v, float f, Vec2& dst)
+    {
+        dst.x = f * v.x;
+        dst.y = f * v.y;
+    }
+
+    inline constexpr Vec2 operator/(const Vec2& lhs, const Vec2& rhs)
+    {
+        return Vec2(lhs.x / rhs.x, lhs.y / rhs.y);
+    }
+
+    inline constexpr void div(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
+    {
+        dst.x = lhs.x / rhs.x;
+        dst.y = lhs.y / rhs.y;
+    }
+
+    inline constexpr float dot(const Vec2& v1, const Vec2& v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y;
+    }
+
+    inline constexpr float lengthSquared(const Vec2& v)
+    {
+        return v.x * v.x + v.y * v.y;
+    }
+
+    inline constexpr float distanceSquared(const Vec2& v1, const Vec2& v2)
+    {
+        float dx = v2.x - v1.x;
+        float dy = v2.y - v1.y;
+
+        return (dx * dx + dy * dy);
+    }
+
+    inline constexpr Vec2 scale(const Vec2& v, float scale)
+    {
+        return {v.x * scale, v.y * scale};
+    }
+
+    inline constexpr void scale(const Vec2& v, float scale, Vec2& dst)
+    {
+        dst.x = v.x * scale;
+        dst.y = v.y * scale;
+    }
+
+    inline constexpr void scale(Vec2& v, float scale)
+    {
+        v.x = v.x * scale;
+        v.y = v.y * scale;
+    }
 }
 }
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "MathTypes.h"
 
 namespace hq
@@ -6,46 +8,197 @@ namespace math
 {
     //////////////////////// Vec3 //////////////////////////
 
-    bool isZero(const Vec3& v);
-    bool isOne(const Vec3& v);
-    Vec3 operator-(const Vec3& v);
-    bool operator <(const Vec3& lhs, const Vec3& rhs);
-    bool operator >(const Vec3& lhs, const Vec3& rhs);
-    Vec3 operator +(const Vec3& lhs, const Vec3& rhs);
-    void add(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
-    Vec3 operator -(const Vec3& lhs, const Vec3& rhs);
-    void sub(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
-    Vec3 operator *(const Vec3& lhs, const Vec3& rhs);
-    void mul(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
-    Vec3 operator *(float f, const Vec3& v);
-    Vec3 operator *(const Vec3& v, float f);
-    void mul(float f, const Vec3& v, Vec3& dst);
-    void mul(const Vec3& v, float f, Vec3& dst);
-    Vec3 operator /(const Vec3& lhs, const Vec3& rhs);
-    void div(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
-
-    float angle(const Vec3& v1, const Vec3& v2);
-    Vec3  clamp(const Vec3& v, const Vec3& min, const Vec3& max);
-    void  clamp(const Vec3& v, const Vec3& min, const Vec3& max, Vec3& dst);
-    void  clamp(Vec3& v, const Vec3& min, const Vec3& max);
-    Vec3  cross(const Vec3& v1, const Vec3& v2);
-    void  cross(const Vec3& v1, const Vec3& v2, Vec3& dst);
-    float dot(const Vec3& v1, const Vec3& v2);
-    float length(const Vec3& v);
-    float lengthSquared(const Vec3& v);
-    float distance(const Vec3& v1, const Vec3& v2);
-    float distanceSquared(const Vec3& v1, const Vec3& v2);
-    Vec3  normalize(const Vec3& v);
-    void  normalize(const Vec3& v, Vec3& dst);
-    void  normalize(Vec3& v);
-    Vec3  scale(const Vec3& v, float scale);
-    void  scale(const Vec3& v, float scale, Vec3& dst);
-    void  scale(Vec3& v, float scale);
-
-    Vec3 minVec(const Vec3& v1, const Vec3& v2);
-    Vec3 maxVec(const Vec3& v1, const Vec3& v2);
+    constexpr bool isZero(const Vec3& v);
+    constexpr bool isOne(const Vec3& v);
+    constexpr Vec3 operator-(const Vec3& v);
+    constexpr bool operator <(const Vec3& lhs, const Vec3& rhs);
+    constexpr bool operator >(const Vec3& lhs, const Vec3& rhs);
+    constexpr Vec3 operator +(const Vec3& lhs, const Vec3& rhs);
+    constexpr void add(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
+    constexpr Vec3 operator -(const Vec3& lhs, const Vec3& rhs);
+    constexpr void sub(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
+    constexpr Vec3 operator *(const Vec3& lhs, const Vec3& rhs);
+    constexpr void mul(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
+    constexpr Vec3 operator *(float f, const Vec3& v);
+    constexpr Vec3 operator *(const Vec3& v, float f);
+    constexpr void mul(float f, const Vec3& v, Vec3& dst);
+    constexpr void mul(const Vec3& v, float f, Vec3& dst);
+    constexpr Vec3 operator /(const Vec3& lhs, const Vec3& rhs);
+    constexpr void div(const Vec3& lhs, const Vec3& rhs, Vec3& dst);
+
+    float           angle(const Vec3& v1, const Vec3& v2);
+    Vec3            clamp(const Vec3& v, const Vec3& min, const Vec3& max);
+    void            clamp(const Vec3& v, const Vec3& min, const Vec3& max, Vec3& dst);
+    void            clamp(Vec3& v, const Vec3& min, const Vec3& max);
+    constexpr Vec3  cross(const Vec3& v1, const Vec3& v2);
+    constexpr void  cross(const Vec3& v1, const Vec3& v2, Vec3& dst);
+    constexpr float dot(const Vec3& v1, const Vec3& v2);
+    float           length(const Vec3& v);
+    constexpr float lengthSquared(const Vec3& v);
+    float           distance(const Vec3& v1, const Vec3& v2);
+    constexpr float distanceSquared(const Vec3& v1, const Vec3& v2);
+    Vec3            normalize(const Vec3& v);
+    void            normalize(const Vec3& v, Vec3& dst);
+    void            normalize(Vec3& v);
+    constexpr Vec3  scale(const Vec3& v, float scale);
+    constexpr void  scale(const Vec3& v, float scale, Vec3& dst);
+    constexpr void  scale(Vec3& v, float scale);
+
+    Vec3  minVec(const Vec3& v1, const Vec3& v2);
+    Vec3  maxVec(const Vec3& v1, const Vec3& v2);
     float maxComponent(const Vec3& v);
     float minComponent(const Vec3& v);
     float meanComponent(const Vec3& v);
+
+    inline constexpr bool isZero(const Vec3& v)
+    {
+        return v.x == 0.f && v.y == 0.f && v.z == 0.f;
+    }
+
+    inline constexpr bool isOne(const Vec3& v)
+    {
+        return v.x == 1.f && v.y == 1.f && v.z == 1.f;
+    }
+
+    inline constexpr Vec3 operator-(const Vec3& v)
+    {
+        return {-v.x, -v.y, -v.z};
+    }
+
+    inline constexpr bool operator<(const Vec3& lhs, const Vec3& rhs)
+    {
+        return lhs.x < rhs.x || lhs.y < rhs.y || lhs.z < rhs.z;
+    }
+
+    inline constexpr bool operator>(const Vec3& lhs, const Vec3& rhs)
+    {
+        return lhs.x > rhs.x || lhs.y > rhs.y || lhs.z > rhs.z;
+    }
+
+    inline constexpr Vec3 operator+(const Vec3& lhs, const Vec3& rhs)
+    {
+        return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+    }
+
+    inline constexpr void add(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
+    {
+        dst.x = lhs.x + rhs.x;
+        dst.y = lhs.y + rhs.y;
+        dst.z = lhs.z + rhs.z;
+    }
+
+    inline constexpr Vec3 operator-(const Vec3& lhs, const Vec3& rhs)
+    {
+        return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+    }
+
+    inline constexpr void sub(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
+    {
+        dst.x = lhs.x - rhs.x;
+        dst.y = lhs.y - rhs.y;
+        dst.z = lhs.z - rhs.z;
+    }
+
+    inline constexpr Vec3 operator*(const Vec3& lhs, const Vec3& rhs)
+    {
+        return {lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z};
+    }
+
+    inline constexpr void mul(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
+    {
+        dst.x = lhs.x * rhs.x;
+        dst.y = lhs.y * rhs.y;
+        dst.z = lhs.z * rhs.z;
+    }
+
+    inline constexpr Vec3 operator*(float f, const Vec3& v)
+    {
+        return Vec3(f * v.x, f * v.y, f * v.z);
+    }
+
+    inline constexpr Vec3 operator*(const Vec3& v, float f)
+    {
+        return Vec3(f * v.x, f * v.y, f * v.z);
+    }
+
+    inline constexpr void mul(float f, const Vec3& v, Vec3& dst)
+    {
+        dst.x = f * v.x;
+        dst.y = f * v.y;
+        dst.z = f * v.z;
+    }
+
+    inline constexpr void mul(const Vec3& v, float f, Vec3& dst)
+    {
+        dst.x = f * v.x;
+        dst.y = f * v.y;
+        dst.z = f * v.z;
+    }
+
+    inline constexpr Vec3 operator/(const Vec3& lhs, const Vec3& rhs)
+    {
+        return {lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z};
+    }
+
+    inline constexpr void div(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
+    {
+        dst.x = lhs.x / rhs.x;
+        dst.y = lhs.y / rhs.y;
+        dst.z = lhs.z / rhs.z;
+    }
+
+    inline constexpr Vec3 cross(const Vec3& v1, const Vec3& v2)
+    {
+        return {
+            v1.y * v2.z - v1.z * v2.y,
+            v1.z * v2.x - v1.x * v2.z,
+            v1.x * v2.y - v1.y * v2.x,
+        };
+    }
+
+    inline constexpr void cross(const Vec3& v1, const Vec3& v2, Vec3& dst)
+    {
+        dst.x = v1.y * v2.z - v1.z * v2.y;
+        dst.y = v1.z * v2.x - v1.x * v2.z;
+        dst.z = v1.x * v2.y - v1.y * v2.x;
+    }
+
+    inline constexpr float dot(const Vec3& v1, const Vec3& v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+    }
+
+    inline constexpr float lengthSquared(const Vec3& v)
+    {
+        return (v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+
+    inline constexpr float distanceSquared(const Vec3& v1, const Vec3& v2)
+    {
+        float dx = v2.x - v1.x;
+        float dy = v2.y - v1.y;
+        float dz = v2.z - v1.z;
+
+        return (dx * dx + dy * dy + dz * dz);
+    }
+
+    inline constexpr Vec3 scale(const Vec3& v, float scale)
+    {
+        return {v.x * scale, v.y * scale, v.z * scale};
+    }
+
+    inline constexpr void scale(const Vec3& v, float scale, Vec3& dst)
+    {
+        dst.x = v.x * scale;
+        dst.y = v.y * scale;
+        dst.z = v.z * scale;
+    }
+
+    inline constexpr void scale(Vec3& v, float scale)
+    {
+        v.x = v.x * scale;
+        v.y = v.y * scale;
+        v.z = v.z * scale;
+    }
 }
 }
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "MathTypes.h"
 
 namespace hq
@@ -6,33 +8,33 @@ namespace math
 {
     //////////////////////// Vec4 //////////////////////////
 
-    bool isZero(const Vec4& v);
-    bool isOne(const Vec4& v);
-    Vec4 operator-(const Vec4& v);
-    Vec4 operator +(const Vec4& lhs, const Vec4& rhs);
-    void add(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
-    Vec4 operator -(const Vec4& lhs, const Vec4& rhs);
-    void sub(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
-    Vec4 operator *(const Vec4& lhs, const Vec4& rhs);
-    void mul(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
-    Vec4 operator /(const Vec4& lhs, const Vec4& rhs);
-    void div(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
-
-    float angle(const Vec4& v1, const Vec4& v2);
-    Vec4  clamp(const Vec4& v, const Vec4& min, const Vec4& max);
-    void  clamp(const Vec4& v, const Vec4& min, const Vec4& max, Vec4& dst);
-    void  clamp(Vec4& v, const Vec4& min, const Vec4& max);
-    float dot(const Vec4& v1, const Vec4& v2);
-    float length(const Vec4& v);
-    float lengthSquared(const Vec4& v);
-    float distance(const Vec4& v1, const Vec4& v2);
-    float distanceSquared(const Vec4& v1, const Vec4& v2);
-    Vec4  normalize(const Vec4& v);
-    void  normalize(const Vec4& v, Vec4& dst);
-    void  normalize(Vec4& v);
-    Vec4  scale(const Vec4& v, float scale);
-    void  scale(const Vec4& v, float scale, Vec4& dst);
-    void  scale(Vec4& v, float scale);
+    constexpr bool isZero(const Vec4& v);
+    constexpr bool isOne(const Vec4& v);
+    constexpr Vec4 operator-(const Vec4& v);
+    constexpr Vec4 operator +(const Vec4& lhs, const Vec4& rhs);
+    constexpr void add(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
+    constexpr Vec4 operator -(const Vec4& lhs, const Vec4& rhs);
+    constexpr void sub(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
+    constexpr Vec4 operator *(const Vec4& lhs, const Vec4& rhs);
+    constexpr void mul(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
+    constexpr Vec4 operator /(const Vec4& lhs, const Vec4& rhs);
+    constexpr void div(const Vec4& lhs, const Vec4& rhs, Vec4& dst);
+
+    float           angle(const Vec4& v1, const Vec4& v2);
+    Vec4            clamp(const Vec4& v, const Vec4& min, const Vec4& max);
+    void            clamp(const Vec4& v, const Vec4& min, const Vec4& max, Vec4& dst);
+    void            clamp(Vec4& v, const Vec4& min, const Vec4& max);
+    constexpr float dot(const Vec4& v1, const Vec4& v2);
+    float           length(const Vec4& v);
+    constexpr float lengthSquared(const Vec4& v);
+    float           distance(const Vec4& v1, const Vec4& v2);
+    constexpr float distanceSquared(const Vec4& v1, const Vec4& v2);
+    Vec4            normalize(const Vec4& v);
+    void            normalize(const Vec4& v, Vec4& dst);
+    void            normalize(Vec4& v);
+    constexpr Vec4  scale(const Vec4& v, float scale);
+    constexpr void  scale(const Vec4& v, float scale, Vec4& dst);
+    constexpr void  scale(Vec4& v, float scale);
 
     Vec4 minVec(const Vec4& v1, const Vec4& v2);
     Vec4 maxVec(const Vec4& v1, const Vec4& v2);
@@ -40,5 +42,116 @@ namespace math
     float maxComponent(const Vec4& v);
     float minComponent(const Vec4& v);
     float meanComponent(const Vec4& v);
+
+    inline constexpr bool isZero(const Vec4& v)
+    {
+        return v.x == 0.f && v.y == 0.f && v.z == 0.f && v.w == 0.f;
+    }
+
+    inline constexpr bool isOne(const Vec4& v)
+    {
+        return v.x == 1.f && v.y == 1.f && v.z == 1.f && v.w == 1.f;
+    }
+
+    inline constexpr Vec4 operator-(const Vec4& v)
+    {
+        return {-v.x, -v.y, -v.z, -v.w};
+    }
+
+    inline constexpr Vec4 operator+(const Vec4& lhs, const Vec4& rhs)
+    {
+        return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
+    }
+
+    inline constexpr void add(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
+    {
+        dst.x = lhs.x + rhs.x;
+        dst.y = lhs.y + rhs.y;
+        dst.z = lhs.z + rhs.z;
+        dst.w = lhs.w + rhs.w;
+    }
+
+    inline constexpr Vec4 operator-(const Vec4& lhs, const Vec4& rhs)
+    {
+        return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
+    }
+
+    inline constexpr void sub(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
+    {
+        dst.x = lhs.x - rhs.x;
+        dst.y = lhs.y - rhs.y;
+        dst.z = lhs.z - rhs.z;
+        dst.w = lhs.w - rhs.w;
+    }
+
+    inline constexpr Vec4 operator*(const Vec4& lhs, const Vec4& rhs)
+    {
+        return {lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w};
+    }
+
+    inline constexpr void mul(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
+    {
+        dst.x = lhs.x * rhs.x;
+        dst.y = lhs.y * rhs.y;
+        dst.z = lhs.z * rhs.z;
+        dst.w = lhs.w * rhs.w;
+    }
+
+    inline constexpr Vec4 operator/(const Vec4& lhs, const Vec4& rhs)
+    {
+        return {lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z, lhs.w / rhs.w};
+    }
+
+    inline constexpr void div(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
+    {
+        dst.x = lhs.x / rhs.x;
+        dst.y = lhs.y / rhs.y;
+        dst.z = lhs.z / rhs.z;
+        dst.w = lhs.w / rhs.w;
+    }
+
+    inline constexpr float dot(const Vec4& v1, const Vec4& v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+    }
+
+    inline constexpr float lengthSquared(const Vec4& v)
+    {
+        return (v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
+    }
+
+    inline constexpr float distanceSquared(const Vec4& v1, const Vec4& v2)
+    {
+        float dx = v2.x - v1.x;
+        float dy = v2.y - v1.y;
+        float dz = v2.z - v1.z;
+        float dw = v2.w - v1.w;
+
+        return (dx * dx + dy * dy + dz * dz + dw * dw);
+    }
+
+    inline constexpr Vec4 scale(const Vec4& v, float scale)
+    {
+        return {v.x * scale,  //
+                v.y * scale,  //
+                v.z * scale,  //
+                v.w * scale};
+    }
+
+    inline constexpr void scale(const Vec4& v, float scale, Vec4& dst)
+    {
+        dst.x = v.x * scale;
+        dst.y = v.y * scale;
+        dst.z = v.z * scale;
+        dst.w = v.w * scale;
+    }
+
+    inline constexpr void scale(Vec4& v, float scale)
+    {
+        v.x = v.x * scale;
+        v.y = v.y * scale;
+        v.z = v.z * scale;
+        v.w = v.w * scale;
+    }
 }
 }
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/Handle.h"
+#include "Hq/Span.h"
+
+#include <cassert>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace hq
+{
+/// std compatible allocator returning memory aligned to Alignment bytes, used to keep SoA columns SIMD friendly
+template <typename T, size_t Alignment>
+struct StdAlignedAllocator
+{
+    static_assert(Alignment >= alignof(T), "Alignment must be at least the natural alignment of T");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = StdAlignedAllocator<U, Alignment>;
+    };
+
+    StdAlignedAllocator() = default;
+
+    template <typename U>
+    StdAlignedAllocator(const StdAlignedAllocator<U, Alignment>&)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const StdAlignedAllocator<U, Alignment>&) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const StdAlignedAllocator<U, Alignment>&) const
+    {
+        return false;
+    }
+};
+
+/// Structure of arrays version of DynPackedFreeList.
+/// Each field type gets its own packed column, so systems touching only a few fields of an object only pull those
+/// fields in cache. Handle and generation semantics are the same as PackedFreeList, removing an object moves the
+/// last object of every column in its place.
+/// @note Field types must be distinct, columns can be accessed either by index or by type.
+/// @example usage:
+///     typedef PackedSoAFreeList<ParticleHandle, Position, Velocity, Color> ParticleStorage;
+///     ParticleStorage storage;
+///     ParticleHandle handle = storage.alloc();
+///     storage.get<Velocity>(handle)->value = {0.f, 1.f, 0.f};
+///     Span<Position> positions = storage.column<Position>();
+///     Span<Velocity> velocities = storage.column<Velocity>();
+///     for (size_t i = 0; i < positions.size(); ++i)
+///         positions[i].value += velocities[i].value * dt;
+/// @tparam H type of the handle of the stored objects
+/// @tparam Fields types of the columns, must be default constructible and move assignable
+template <typename H, typename... Fields>
+class PackedSoAFreeList
+{
+public:
+    /// columns start on a cache line so they can be processed with aligned SIMD loads
+    static const size_t kColumnAlignment = 64;
+
+    template <typename Field>
+    using Column = std::vector<Field, StdAlignedAllocator<Field, kColumnAlignment>>;
+
+    template <size_t I>
+    using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    explicit PackedSoAFreeList(size_t capacity = 0)
+    {
+        reserve(capacity);
+    }
+
+    /// Removes all objects and resets the free list, all handles given before are no longer valid
+    void clear()
+    {
+        _freeList.clear();
+        _indices.clear();
+        std::apply([](auto&... column) { (column.clear(), ...); }, _columns);
+        _freeHead = 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        _freeList.reserve(capacity);
+        _indices.reserve(capacity);
+        std::apply([capacity](auto&... column) { (column.reserve(capacity), ...); }, _columns);
+    }
+
+    void shrink_to_fit()
+    {
+        _freeList.shrink_to_fit();
+        _indices.shrink_to_fit();
+        std::apply([](auto&... column) { (column.shrink_to_fit(), ...); }, _columns);
+    }
+
+    size_t size() const
+    {
+        return _indices.size();
+    }
+
+    bool isValid(const H& handle) const
+    {
+        return ((handle.index() < _freeList.size()) && (handle.generation() != 0) &&
+                (_freeList[handle.index()].generation() == handle.generation()));
+    }
+
+    H alloc()
+    {
+        if (_freeHead >= _freeList.size())
+        {
+            // free list exhausted, append a new slot that points past the end
+            _freeList.emplace_back(static_cast<u32>(_freeList.size() + 1), 1);
+        }
+
+        const u32 freeIndex = _freeHead;
+        _freeHead           = _freeList[freeIndex].index();
+        // storage location is first element beyond last
+        _freeList[freeIndex].setIndex(static_cast<u32>(_indices.size()));
+        // point back to freelist element
+        _indices.push_back(freeIndex);
+        std::apply([](auto&... column) { (column.emplace_back(), ...); }, _columns);
+
+        H handle(freeIndex, _freeList[freeIndex].generation());
+        return handle;
+    }
+
+    void remove(const H& handle)
+    {
+        if (!isValid(handle))
+            return;
+
+        // increment the generation
+        _freeList[handle.index()].setGeneration(_freeList[handle.index()].generation() + 1);
+        if (_freeList[handle.index()].generation() == 0)
+            _freeList[handle.index()].setGeneration(1);
+
+        const u32 releasedIndex = _freeList[handle.index()].index();
+        const u32 lastIndex     = static_cast<u32>(_indices.size() - 1);
+        if (releasedIndex != lastIndex)
+        {
+            // move the last item of every column in the released place to preserve packing
+            std::apply(
+                [releasedIndex, lastIndex](auto&... column) {
+                    ((column[releasedIndex] = std::move(column[lastIndex])), ...);
+                },
+                _columns);
+            _indices[releasedIndex] = _indices[lastIndex];
+            // make freelist for moved element point to the new location
+            _freeList[_indices[releasedIndex]].setIndex(releasedIndex);
+        }
+
+        _indices.pop_back();
+        std::apply([](auto&... column) { (column.pop_back(), ...); }, _columns);
+
+        // set the release freelist index point to the next free one
+        _freeList[handle.index()].setIndex(_freeHead);
+        // and set the new free head here
+        _freeHead = handle.index();
+    }
+
+    template <size_t I>
+    FieldType<I>* get(const H& handle)
+    {
+        return isValid(handle) ? &std::get<I>(_columns)[_freeList[handle.index()].index()] : nullptr;
+    }
+
+    template <size_t I>
+    const FieldType<I>* get(const H& handle) const
+    {
+        return isValid(handle) ? &std::get<I>(_columns)[_freeList[handle.index()].index()] : nullptr;
+    }
+
+    template <typename Field>
+    Field* get(const H& handle)
+    {
+        return isValid(handle) ? &std::get<Column<Field>>(_columns)[_freeList[handle.index()].index()] : nullptr;
+    }
+
+    template <typename Field>
+    const Field* get(const H& handle) const
+    {
+        return isValid(handle) ? &std::get<Column<Field>>(_columns)[_freeList[handle.index()].index()] : nullptr;
+    }
+
+    u32 getPackedIndex(const H& handle) const
+    {
+        if (isValid(handle))
+            return _freeList[handle.index()].index();
+
+        return static_cast<u32>(kInvalidPackedIndex);
+    }
+
+    H getHandleFromPackedIndex(u32 index) const
+    {
+        assert(index < _indices.size());
+        H handle(_indices[index], _freeList[_indices[index]].generation());
+        return handle;
+    }
+
+    /// Packed column of the I-th field, aligned to kColumnAlignment, element i belongs to
+    /// getHandleFromPackedIndex(i). Invalidated by alloc and remove.
+    template <size_t I>
+    Span<FieldType<I>> column()
+    {
+        return Span<FieldType<I>>(std::get<I>(_columns));
+    }
+
+    template <size_t I>
+    Span<const FieldType<I>> column() const
+    {
+        return Span<const FieldType<I>>(std::get<I>(_columns));
+    }
+
+    template <typename Field>
+    Span<Field> column()
+    {
+        return Span<Field>(std::get<Column<Field>>(_columns));
+    }
+
+    template <typename Field>
+    Span<const Field> column() const
+    {
+        return Span<const Field>(std::get<Column<Field>>(_columns));
+    }
+
+private:
+    u32                           _freeHead {0};
+    std::vector<H>                _freeList;
+    // packed location -> freelist index
+    std::vector<u32>              _indices;
+    std::tuple<Column<Fields>...> _columns;
+};
+}  // namespace hq
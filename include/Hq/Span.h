@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+namespace hq
+{
+/// Non owning view over a contiguous sequence of objects (stand-in for std::span until we move to C++20)
+template <typename T>
+class Span
+{
+public:
+    using element_type = T;
+    using iterator     = T*;
+
+    constexpr Span() = default;
+
+    constexpr Span(T* data, size_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    template <size_t N>
+    constexpr Span(T (&array)[N])
+        : _data(array)
+        , _size(N)
+    {
+    }
+
+    /// Any container with contiguous `data()` and `size()` (std::vector, std::array, ...)
+    template <typename Container, typename = decltype(std::declval<Container&>().data())>
+    constexpr Span(Container& container)
+        : _data(container.data())
+        , _size(container.size())
+    {
+    }
+
+    constexpr T* data() const
+    {
+        return _data;
+    }
+
+    constexpr size_t size() const
+    {
+        return _size;
+    }
+
+    constexpr bool empty() const
+    {
+        return _size == 0;
+    }
+
+    constexpr T* begin() const
+    {
+        return _data;
+    }
+
+    constexpr T* end() const
+    {
+        return _data + _size;
+    }
+
+    T& operator[](size_t i) const
+    {
+        assert(i < _size);
+        return _data[i];
+    }
+
+    Span subspan(size_t offset, size_t count) const
+    {
+        assert(offset + count <= _size);
+        return Span(_data + offset, count);
+    }
+
+private:
+    T*     _data {nullptr};
+    size_t _size {0};
+};
+}  // namespace hq
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/FSM.h"
+#include "Hq/JobManager.h"
+#include "Hq/Span.h"
+
+#include <array>
+#include <cassert>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hq
+{
+static const size_t kStateMachineBankBatchSize = 256;
+
+/// Many instances of the same state machine processed in batches (AI agents, doors, spawners...).
+/// Instances are grouped by current state: the contexts of a state are packed in one array and the tick function of
+/// the state is called once with the whole group, so ticking thousands of instances is a few tight loops instead of
+/// a lookup and an indirect call per instance.
+/// Transitions returned by the tick functions are applied once every group was ticked: the context moves to the
+/// group of its new state (leave and enter are called per instance).
+/// States are indexed by the enum, see EnumCount.
+/// @note contexts move between groups when their state changes, don't keep pointers to them across ticks.
+/// @example usage:
+///     StateMachineBank<AiState, Agent> bank;
+///     bank.addState(AiState::Idle, enterIdle, [](Span<Agent> agents, Span<std::optional<AiState>> transitions) {
+///         for (size_t i = 0; i < agents.size(); ++i)
+///             if (agents[i].seesEnemy) transitions[i] = AiState::Chase;
+///     }, leaveIdle);
+///     auto id = bank.add(AiState::Idle, Agent {});
+///     bank.tick(jobManager);
+template <typename EnumClass, typename Context>
+class StateMachineBank
+{
+public:
+    using StateType              = EnumClass;
+    using ContextType            = Context;
+    using ResultType             = std::optional<StateType>;
+    using InstanceId             = u32;
+    using LeaveFunctionType      = std::function<void(ContextType&)>;
+    using TransitionFunctionType = std::function<ResultType(ContextType&)>;
+    /// Ticks every instance of a state, sets `transitions[i]` to change the state of `contexts[i]`
+    using BatchTickFunctionType = std::function<void(Span<ContextType> contexts, Span<ResultType> transitions)>;
+
+    static constexpr size_t kStateCount = EnumCount<EnumClass>::value;
+
+    /// Functions can be empty, a state without tick function never leaves by itself
+    void addState(StateType state, TransitionFunctionType&& enterFunc, BatchTickFunctionType&& tickFunc,
+                  LeaveFunctionType&& leaveFunc)
+    {
+        Group& group    = _groups[index(state)];
+        group.enterFunc = std::move(enterFunc);
+        group.tickFunc  = std::move(tickFunc);
+        group.leaveFunc = std::move(leaveFunc);
+    }
+
+    /// Adds an instance and enters its initial state
+    InstanceId add(StateType initialState, ContextType context)
+    {
+        InstanceId id;
+        if (!_freeIds.empty())
+        {
+            id = _freeIds.back();
+            _freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<InstanceId>(_locations.size());
+            _locations.emplace_back();
+        }
+
+        insert(id, index(initialState), std::move(context));
+        ++_size;
+        enter(id);
+        return id;
+    }
+
+    /// Leaves the current state and removes the instance
+    void remove(InstanceId id)
+    {
+        assert(isValid(id));
+        const Location location = _locations[id];
+        Group&         group    = _groups[location.state];
+        if (group.leaveFunc)
+            group.leaveFunc(group.contexts[location.slot]);
+        erase(id);
+        _locations[id] = Location {};
+        _freeIds.push_back(id);
+        --_size;
+    }
+
+    void changeState(InstanceId id, StateType state)
+    {
+        assert(isValid(id));
+        moveTo(id, index(state));
+        enter(id);
+    }
+
+    /// Ticks every group on the calling thread then applies the transitions
+    void tick()
+    {
+        for (Group& group : _groups)
+        {
+            group.transitions.assign(group.contexts.size(), std::nullopt);
+            if (group.tickFunc && !group.contexts.empty())
+                group.tickFunc(Span<ContextType>(group.contexts), Span<ResultType>(group.transitions));
+        }
+        applyTransitions();
+    }
+
+    /// Ticks the groups from the job manager workers, split in batches of kStateMachineBankBatchSize instances.
+    /// Tick functions must be safe to call concurrently for different batches of the same state.
+    void tick(JobManager& jobManager)
+    {
+        for (Group& group : _groups)
+        {
+            group.transitions.assign(group.contexts.size(), std::nullopt);
+            if (!group.tickFunc || group.contexts.empty())
+                continue;
+
+            jobManager.parallel_for<ContextType, CountSplitter<ContextType, kStateMachineBankBatchSize>>(
+                [&group](void* data, size_t count) {
+                    ContextType* contexts = static_cast<ContextType*>(data);
+                    const size_t first    = static_cast<size_t>(contexts - group.contexts.data());
+                    group.tickFunc(Span<ContextType>(contexts, count),
+                                   Span<ResultType>(group.transitions.data() + first, count));
+                },
+                group.contexts.data(), group.contexts.size());
+        }
+        jobManager.wait();
+        applyTransitions();
+    }
+
+    bool isValid(InstanceId id) const
+    {
+        return id < _locations.size() && _locations[id].state != kNoState;
+    }
+
+    StateType currentState(InstanceId id) const
+    {
+        assert(isValid(id));
+        return static_cast<StateType>(_locations[id].state);
+    }
+
+    ContextType& context(InstanceId id)
+    {
+        assert(isValid(id));
+        return _groups[_locations[id].state].contexts[_locations[id].slot];
+    }
+
+    /// Contexts of the instances currently in `state`, packed
+    Span<ContextType> contexts(StateType state)
+    {
+        return Span<ContextType>(_groups[index(state)].contexts);
+    }
+
+    size_t count(StateType state) const
+    {
+        return _groups[index(state)].contexts.size();
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    static constexpr u32 kNoState = 0xffffffff;
+
+    struct Location
+    {
+        u32 state {kNoState};
+        u32 slot {0};
+    };
+
+    struct Group
+    {
+        std::vector<ContextType> contexts;
+        std::vector<InstanceId>  ids;
+        std::vector<ResultType>  transitions;
+        TransitionFunctionType   enterFunc;
+        BatchTickFunctionType    tickFunc;
+        LeaveFunctionType        leaveFunc;
+    };
+
+    static u32 index(StateType state)
+    {
+        assert(static_cast<size_t>(state) < kStateCount);
+        return static_cast<u32>(state);
+    }
+
+    void insert(InstanceId id, u32 state, ContextType&& context)
+    {
+        Group& group   = _groups[state];
+        _locations[id] = Location {state, static_cast<u32>(group.contexts.size())};
+        group.contexts.push_back(std::move(context));
+        group.ids.push_back(id);
+    }
+
+    // swap and pop, the last instance of the group takes the slot
+    ContextType erase(InstanceId id)
+    {
+        const Location location = _locations[id];
+        Group&         group    = _groups[location.state];
+        ContextType    context  = std::move(group.contexts[location.slot]);
+        if (location.slot + 1 != group.contexts.size())
+        {
+            group.contexts[location.slot]             = std::move(group.contexts.back());
+            group.ids[location.slot]                  = group.ids.back();
+            _locations[group.ids[location.slot]].slot = location.slot;
+        }
+        group.contexts.pop_back();
+        group.ids.pop_back();
+        return context;
+    }
+
+    void moveTo(InstanceId id, u32 state)
+    {
+        Group& group = _groups[_locations[id].state];
+        if (group.leaveFunc)
+            group.leaveFunc(group.contexts[_locations[id].slot]);
+        insert(id, state, erase(id));
+    }
+
+    // enters the current state, follows the transitions returned by the enter functions
+    void enter(InstanceId id)
+    {
+        while (true)
+        {
+            Group& group = _groups[_locations[id].state];
+            if (!group.enterFunc)
+                return;
+            const ResultType transition = group.enterFunc(group.contexts[_locations[id].slot]);
+            if (!transition)
+                return;
+            moveTo(id, index(*transition));
+        }
+    }
+
+    void applyTransitions()
+    {
+        // collected first, changing state moves instances between groups
+        _pending.clear();
+        for (Group& group : _groups)
+        {
+            for (size_t i = 0; i < group.transitions.size(); ++i)
+            {
+                if (group.transitions[i])
+                    _pending.emplace_back(group.ids[i], *group.transitions[i]);
+            }
+        }
+
+        for (const auto& [id, state] : _pending)
+            changeState(id, state);
+    }
+
+private:
+    std::array<Group, kStateCount>                _groups;
+    std::vector<Location>                         _locations;
+    std::vector<InstanceId>                       _freeIds;
+    std::vector<std::pair<InstanceId, StateType>> _pending;
+    size_t                                        _size {0};
+};
+}  // namespace hq
@@ -1,12 +1,41 @@
 #pragma once
 
 #include "Hq/BasicTypes.h"
+#include "Hq/CompileHash.h"
+#include "Hq/Span.h"
 
 #include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace hq
 {
+u32 MurmurHash3_32(const void* key, uint len, u32 seed);
+/// wyhash (final version 4), 64 bit hash much faster than Murmur3 on strings longer than a few bytes
+u64 WyHash64(const void* key, size_t len, u64 seed);
+
+#ifdef HQ_STRING_HASH_64
+static const u32 kStringHashBits = 64;
+#else
+static const u32 kStringHashBits = 32;
+#endif
+static const u32 kStringHashSeed = 0x12345678;
+
+/// Hash of the string data, WyHash64 when built WITH_STRING_HASH_64 otherwise MurmurHash3_32
+size_t hashString(const char* str, size_t len);
+
+/// constexpr version of hashString, gives the same value
+constexpr size_t compileHashString(const char* str, size_t len)
+{
+#ifdef HQ_STRING_HASH_64
+    return static_cast<size_t>(compile::wyhash64(str, len, kStringHashSeed));
+#else
+    return compile::murmur3_32(str, len, kStringHashSeed);
+#endif
+}
+
+/// StringHash of a string, 32 bit Murmur3 by default or 64 bit wyhash when built WITH_STRING_HASH_64
+/// (HQ_STRING_HASH_64 defined). Both options give different values, don't mix serialized hashes between them.
 class StringHash
 {
 public:
@@ -16,13 +45,17 @@ public:
         size_t operator()(const StringHash& s) const;
     };
 
-    StringHash();
+    constexpr StringHash();
     StringHash(const char* str);
     StringHash(const std::string& str);
-    bool operator==(const StringHash& other) const;
-         operator size_t() const;
+    explicit StringHash(std::string_view str);
+    constexpr bool operator==(const StringHash& other) const;
+    constexpr      operator size_t() const;
+
+    constexpr size_t hash() const;
 
-    size_t hash() const;
+    /// StringHash from an already computed hash (hashString/compileHashString)
+    static constexpr StringHash fromHash(size_t hash);
 
     template <class Serializer>
     void Serialize(Serializer& serializer)
@@ -34,22 +67,42 @@ private:
     size_t _hash;
 };
 
+/// Hashes a batch of strings (asset paths at startup...) into hashes[0, strings.size())
+void hashMany(Span<const std::string_view> strings, StringHash* hashes);
+
 inline size_t StringHash::Hasher::operator()(const StringHash& s) const
 {
     // StringHash objects are already hashed during creation, return hash
     return s._hash;
 }
 
-inline bool StringHash::operator==(const StringHash& other) const
+constexpr StringHash::StringHash()
+    : _hash(0)
+{
+}
+
+constexpr bool StringHash::operator==(const StringHash& other) const
 {
     return _hash == other._hash;
 }
 
-inline StringHash::operator size_t() const
+constexpr StringHash::operator size_t() const
 {
     return _hash;
 }
 
+constexpr size_t StringHash::hash() const
+{
+    return _hash;
+}
+
+constexpr StringHash StringHash::fromHash(size_t hash)
+{
+    StringHash stringHash;
+    stringHash._hash = hash;
+    return stringHash;
+}
+
 inline u32 rotl32(u32 x, i8 r)
 {
     return (x << r) | (x >> (32 - r));
@@ -73,8 +126,10 @@ inline u32 fmix32(u32 h)
 }  // atlas namespace
 
 
-inline hq::StringHash operator""_sh(const char *str, std::size_t) noexcept {
-    return hq::StringHash{str};
+/// Compile time StringHash, "name"_sh == StringHash("name") and can be used in switch cases
+constexpr hq::StringHash operator""_sh(const char* str, std::size_t len) noexcept
+{
+    return hq::StringHash::fromHash(hq::compileHashString(str, len));
 }
 
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Hq/BasicTypes.h"
+#include "Hq/FlatHashMap.h"
+#include "Hq/SpinLock.h"
+#include "Hq/StringHash.h"
+
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace hq
+{
+/// Thread-safe table of interned strings, gives the string back from its StringHash (debug names, tools) and
+/// detects hash collisions when a string is interned.
+/// Strings are split over shards by hash, each shard has its own lock, map and arena for the string bytes, so
+/// threads interning different strings rarely wait on each other. Interned strings are never moved or freed
+/// until `clear`, `lookup` pointers stay valid.
+/// Built WITH_STRING_INTERNING (HQ_STRING_INTERNING defined), every StringHash created from a string at runtime
+/// is interned in `StringTable::global()`. `_sh` literals are computed at compile time and are not interned.
+/// The table can be saved and loaded so release builds can get names back offline.
+/// @example usage:
+///     StringTable::global().intern("player");
+///     const char* name = StringTable::global().lookup(hash);  // nullptr if the string was never interned
+class StringTable
+{
+public:
+    static const u32    kShardCount     = 64;
+    static const size_t kArenaBlockSize = 64 * 1024;
+
+    /// Called with the hash, the string interned first and the colliding one
+    using CollisionHandler = void (*)(StringHash hash, const char* interned, std::string_view other);
+
+    StringTable() = default;
+    StringTable(const StringTable&) = delete;
+    StringTable& operator=(const StringTable&) = delete;
+
+    static StringTable& global();
+
+    /// Returns false if another string with the same hash was interned before
+    bool intern(std::string_view str);
+    bool intern(std::string_view str, StringHash hash);
+
+    /// Interned string of a hash, nullptr if unknown
+    const char* lookup(StringHash hash) const;
+
+    size_t size() const;
+    size_t collisionCount() const;
+    void   setCollisionHandler(CollisionHandler handler);
+    void   clear();
+
+    /// Binary dump of every interned string, only loads back in a build using the same StringHash width
+    void save(std::ostream& out) const;
+    /// Interns all strings of a dump, returns false if the dump is invalid or comes from another hash width
+    bool load(std::istream& in);
+
+private:
+    struct Entry
+    {
+        const char* str;
+        u32         length;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable SpinLock                     lock;
+        FlatHashMap<StringHash, Entry>       strings;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t                               blockUsed {kArenaBlockSize};
+
+        const char* store(std::string_view str);
+    };
+
+    Shard& shard(StringHash hash)
+    {
+        return _shards[(hash.hash() >> 8) % kShardCount];
+    }
+
+    const Shard& shard(StringHash hash) const
+    {
+        return _shards[(hash.hash() >> 8) % kShardCount];
+    }
+
+    Shard                         _shards[kShardCount];
+    std::atomic<size_t>           _collisions {0};
+    std::atomic<CollisionHandler> _collisionHandler {nullptr};
+};
+}  // namespace hq
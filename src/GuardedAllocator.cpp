@@ -0,0 +1,190 @@
+#include "Hq/GuardedAllocator.h"
+
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define HQ_ASAN_ENABLED
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define HQ_ASAN_ENABLED
+#endif
+#endif
+
+#ifdef HQ_ASAN_ENABLED
+#include <sanitizer/asan_interface.h>
+#define POISON_REGION(addr, size) ASAN_POISON_MEMORY_REGION(addr, size)
+#define UNPOISON_REGION(addr, size) ASAN_UNPOISON_MEMORY_REGION(addr, size)
+#else
+#define POISON_REGION(addr, size) ((void)(addr), (void)(size))
+#define UNPOISON_REGION(addr, size) ((void)(addr), (void)(size))
+#endif
+
+namespace
+{
+const u32 kHeaderMagic = 0x47415244;  // "GARD"
+
+size_t systemPageSize()
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void* mapPages(size_t size)
+{
+#ifdef WIN32
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+void protectPages(void* p, size_t size)
+{
+#ifdef WIN32
+    DWORD oldProtect;
+    VirtualProtect(p, size, PAGE_NOACCESS, &oldProtect);
+#else
+    mprotect(p, size, PROT_NONE);
+#endif
+}
+
+void unmapPages(void* p, size_t size)
+{
+#ifdef WIN32
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+
+size_t roundUp(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+}  // namespace
+
+GuardedAllocator::GuardedAllocator(size_t size, size_t quarantineSize)
+    : Allocator(size, nullptr)
+    , _pageSize(systemPageSize())
+    , _quarantineSize(quarantineSize)
+    , _quarantineHead(0)
+    , _quarantine(nullptr)
+{
+    assert(size > 0);
+
+    if (_quarantineSize > 0)
+        _quarantine = new AllocationHeader[_quarantineSize]();
+}
+
+GuardedAllocator::~GuardedAllocator()
+{
+    for (size_t i = 0; i < _quarantineSize; ++i)
+    {
+        const AllocationHeader& header = _quarantine[i];
+        if (header.base != nullptr)
+        {
+            // The range can be mapped again by anyone once released, it must not stay poisoned
+            UNPOISON_REGION(pointer_math::add(header.base, _pageSize), header.mappedSize - 2 * _pageSize);
+            unmapPages(header.base, header.mappedSize);
+        }
+    }
+
+    delete[] _quarantine;
+    _quarantine = nullptr;
+}
+
+size_t GuardedAllocator::getQuarantinedCount() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < _quarantineSize; ++i)
+    {
+        if (_quarantine[i].base != nullptr)
+            ++count;
+    }
+    return count;
+}
+
+void* GuardedAllocator::allocate(size_t size, u8 alignment)
+{
+    assert(size != 0 && alignment != 0);
+
+    if (_used_memory + size > _size)
+        return nullptr;
+
+    // Layout: [guard page][header + padding + user block][guard page]
+    // The user block ends as close to the trailing guard page as the alignment allows, so any overflow
+    // bigger than the alignment padding touches the protected page.
+    const size_t alignedSize = roundUp(size, alignment);
+    const size_t dataSize    = roundUp(alignedSize + sizeof(AllocationHeader), _pageSize);
+    const size_t mappedSize  = dataSize + 2 * _pageSize;
+
+    void* base = mapPages(mappedSize);
+    if (base == nullptr)
+        return nullptr;
+
+    void* trailingGuard = pointer_math::add(base, _pageSize + dataSize);
+    protectPages(base, _pageSize);
+    protectPages(trailingGuard, _pageSize);
+
+    void* p = pointer_math::alignBackward(pointer_math::subtract(trailingGuard, size), alignment);
+
+    // Header is not necessarily aligned for its members when the requested alignment is small, copy it
+    AllocationHeader header {kHeaderMagic, base, mappedSize, size};
+    std::memcpy(pointer_math::subtract(p, sizeof(AllocationHeader)), &header, sizeof(AllocationHeader));
+
+    _used_memory += size;
+    _num_allocations++;
+
+    return p;
+}
+
+void GuardedAllocator::deallocate(void* p)
+{
+    assert(p != nullptr);
+
+    // A double free faults here, the header page is already protected
+    AllocationHeader header;
+    std::memcpy(&header, pointer_math::subtract(p, sizeof(AllocationHeader)), sizeof(AllocationHeader));
+    assert(header.magic == kHeaderMagic && "Corrupted allocation header or pointer not owned by this allocator");
+
+    std::memset(p, kPoisonByte, header.size);
+    POISON_REGION(p, header.size);
+
+    protectPages(pointer_math::add(header.base, _pageSize), header.mappedSize - 2 * _pageSize);
+
+    _used_memory -= header.size;
+    _num_allocations--;
+
+    if (_quarantineSize == 0)
+    {
+        UNPOISON_REGION(p, header.size);
+        unmapPages(header.base, header.mappedSize);
+        return;
+    }
+
+    // Keep the block protected until it falls out of the quarantine, so a dangling pointer keeps faulting
+    // instead of pointing into a fresh allocation that reuses the same pages
+    AllocationHeader& evicted = _quarantine[_quarantineHead];
+    if (evicted.base != nullptr)
+    {
+        UNPOISON_REGION(pointer_math::add(evicted.base, _pageSize), evicted.mappedSize - 2 * _pageSize);
+        unmapPages(evicted.base, evicted.mappedSize);
+    }
+
+    evicted         = header;
+    _quarantineHead = (_quarantineHead + 1) % _quarantineSize;
+}
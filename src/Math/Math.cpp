@@ -25,8 +25,99 @@
 #include <cstdio>
 #include <cstdlib>
 
+// SIMD backend, SSE when the target has it unless HQ_MATH_SCALAR is defined (WITH_MATH_SCALAR).
+// AVX and FMA are only used when the compiler targets them (WITH_MATH_AVX2), every path has a scalar fallback.
+#if !defined(HQ_MATH_SCALAR) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#include <xmmintrin.h>
+#define HQ_MATH_SSE 1
+#else
+#define HQ_MATH_SSE 0
+#endif
+
+#if HQ_MATH_SSE && defined(__AVX__)
+#include <immintrin.h>
+#define HQ_MATH_AVX 1
+#else
+#define HQ_MATH_AVX 0
+#endif
+
+#if HQ_MATH_SSE && (defined(__FMA__) || defined(__AVX2__))
+#include <immintrin.h>
+#define HQ_MATH_FMA 1
+#else
+#define HQ_MATH_FMA 0
+#endif
+
 namespace hq::math
 {
+////////////////////// SIMD helpers ////////////////////////////////
+
+#if HQ_MATH_SSE
+namespace
+{
+    inline __m128 load(const float* data)
+    {
+        return _mm_loadu_ps(data);
+    }
+
+    inline void store(__m128 v, float* data)
+    {
+        _mm_storeu_ps(data, v);
+    }
+
+    // lanes X, Y, Z, W of `v`
+    template <int X, int Y, int Z, int W>
+    inline __m128 swizzle(__m128 v)
+    {
+        return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+    }
+
+    // lanes X, Y of `a` then lanes Z, W of `b`
+    template <int X, int Y, int Z, int W>
+    inline __m128 shuffle(__m128 a, __m128 b)
+    {
+        return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+    }
+
+    // a * b + c
+    inline __m128 madd(__m128 a, __m128 b, __m128 c)
+    {
+#if HQ_MATH_FMA
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    // sum of the lanes, in every lane
+    inline __m128 sum(__m128 v)
+    {
+        v = _mm_add_ps(v, swizzle<2, 3, 0, 1>(v));
+        return _mm_add_ps(v, swizzle<1, 0, 3, 2>(v));
+    }
+
+    inline __m128 dot4(__m128 a, __m128 b)
+    {
+        return sum(_mm_mul_ps(a, b));
+    }
+
+    // flips the sign of the lanes set in the mask
+    inline __m128 negate(__m128 v, __m128 signMask)
+    {
+        return _mm_xor_ps(v, signMask);
+    }
+
+    // columns of `m` weighted by the lanes of `v`: the product m * v
+    inline __m128 combineColumns(const float* m, __m128 v)
+    {
+        __m128 r = _mm_mul_ps(load(m), swizzle<0, 0, 0, 0>(v));
+        r        = madd(load(m + 4), swizzle<1, 1, 1, 1>(v), r);
+        r        = madd(load(m + 8), swizzle<2, 2, 2, 2>(v), r);
+        return madd(load(m + 12), swizzle<3, 3, 3, 3>(v), r);
+    }
+}  // namespace
+#endif
+
 ////////////////////// Base functions ////////////////////////////////
 
 const float kInfinity = bitsToFloat(UINT32_C(0x7f800000));
@@ -264,102 +355,9 @@ Vec2::Vec2(const float* data)
     y = data[1];
 }
 
-float& Vec2::operator[](size_t i)
-{
-    assert(i < 2);
-    return data[i];
-}
-
-const float& Vec2::operator[](size_t i) const
-{
-    assert(i < 2);
-    return data[i];
-}
-
 const Vec2 Vec2::Zero(0.f);
 const Vec2 Vec2::One(1.f);
 
-bool isZero(const Vec2& v)
-{
-    return v.x == 0.f && v.y == 0.f;
-}
-
-bool isOne(const Vec2& v)
-{
-    return v.x == 1.f && v.y == 1.f;
-}
-
-Vec2 operator-(const Vec2& v)
-{
-    return Vec2(-v.x, -v.y);
-}
-
-Vec2 operator+(const Vec2& lhs, const Vec2& rhs)
-{
-    return Vec2(lhs.x + rhs.x, lhs.y + rhs.y);
-}
-
-void add(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
-{
-    dst.x = lhs.x + rhs.x;
-    dst.y = lhs.y + rhs.y;
-}
-
-Vec2 operator-(const Vec2& lhs, const Vec2& rhs)
-{
-    return Vec2(lhs.x - rhs.x, lhs.y - rhs.y);
-}
-
-void sub(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
-{
-    dst.x = lhs.x - rhs.x;
-    dst.y = lhs.y - rhs.y;
-}
-
-Vec2 operator*(const Vec2& lhs, const Vec2& rhs)
-{
-    return Vec2(lhs.x * rhs.x, lhs.y * rhs.y);
-}
-
-void mul(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
-{
-    dst.x = lhs.x * rhs.x;
-    dst.y = lhs.y * rhs.y;
-}
-
-Vec2 operator*(float f, const Vec2& v)
-{
-    return Vec2(f * v.x, f * v.y);
-}
-
-Vec2 operator*(const Vec2& v, float f)
-{
-    return Vec2(f * v.x, f * v.y);
-}
-
-void mul(float f, const Vec2& v, Vec2& dst)
-{
-    dst.x = f * v.x;
-    dst.y = f * v.y;
-}
-
-void mul(const Vec2& v, float f, Vec2& dst)
-{
-    dst.x = f * v.x;
-    dst.y = f * v.y;
-}
-
-Vec2 operator/(const Vec2& lhs, const Vec2& rhs)
-{
-    return Vec2(lhs.x / rhs.x, lhs.y / rhs.y);
-}
-
-void div(const Vec2& lhs, const Vec2& rhs, Vec2& dst)
-{
-    dst.x = lhs.x / rhs.x;
-    dst.y = lhs.y / rhs.y;
-}
-
 float angle(const Vec2& v1, const Vec2& v2)
 {
     float dz = v1.x * v2.y - v1.y * v2.x;
@@ -383,21 +381,11 @@ void clamp(Vec2& v, const Vec2& min, const Vec2& max)
     clamp(v, min, max, v);
 }
 
-float dot(const Vec2& v1, const Vec2& v2)
-{
-    return v1.x * v2.x + v1.y * v2.y;
-}
-
 float length(const Vec2& v)
 {
     return sqrt(v.x * v.x + v.y * v.y);
 }
 
-float lengthSquared(const Vec2& v)
-{
-    return v.x * v.x + v.y * v.y;
-}
-
 float distance(const Vec2& v1, const Vec2& v2)
 {
     float dx = v2.x - v1.x;
@@ -406,14 +394,6 @@ float distance(const Vec2& v1, const Vec2& v2)
     return sqrt(dx * dx + dy * dy);
 }
 
-float distanceSquared(const Vec2& v1, const Vec2& v2)
-{
-    float dx = v2.x - v1.x;
-    float dy = v2.y - v1.y;
-
-    return (dx * dx + dy * dy);
-}
-
 Vec2 normalize(const Vec2& v)
 {
     const float invLen = 1.0f / length(v);
@@ -433,23 +413,6 @@ void normalize(Vec2& v)
     scale(v, invLen, v);
 }
 
-Vec2 scale(const Vec2& v, float scale)
-{
-    return {v.x * scale, v.y * scale};
-}
-
-void scale(const Vec2& v, float scale, Vec2& dst)
-{
-    dst.x = v.x * scale;
-    dst.y = v.y * scale;
-}
-
-void scale(Vec2& v, float scale)
-{
-    v.x = v.x * scale;
-    v.y = v.y * scale;
-}
-
 Vec2 rotate(const Vec2& v, const Vec2& point, float angle)
 {
     Vec2 result;
@@ -517,18 +480,6 @@ Vec2i::Vec2i(const int* data)
     y = data[1];
 }
 
-int& Vec2i::operator[](size_t i)
-{
-    assert(i < 2);
-    return data[i];
-}
-
-const int& Vec2i::operator[](size_t i) const
-{
-    assert(i < 2);
-    return data[i];
-}
-
 const Vec2i Vec2i::Zero(0);
 const Vec2i Vec2i::One(1);
 
@@ -677,118 +628,9 @@ Vec3::Vec3(const Vec2& v, float a)
 {
 }
 
-float& Vec3::operator[](size_t i)
-{
-    assert(i < 3);
-    return data[i];
-}
-
-const float& Vec3::operator[](size_t i) const
-{
-    assert(i < 3);
-    return data[i];
-}
-
 const Vec3 Vec3::Zero(0.f);
 const Vec3 Vec3::One(1.f);
 
-bool isZero(const Vec3& v)
-{
-    return v.x == 0.f && v.y == 0.f && v.z == 0.f;
-}
-
-bool isOne(const Vec3& v)
-{
-    return v.x == 1.f && v.y == 1.f && v.z == 1.f;
-}
-
-Vec3 operator-(const Vec3& v)
-{
-    return {-v.x, -v.y, -v.z};
-}
-
-bool operator<(const Vec3& lhs, const Vec3& rhs)
-{
-    return lhs.x < rhs.x || lhs.y < rhs.y || lhs.z < rhs.z;
-}
-
-bool operator>(const Vec3& lhs, const Vec3& rhs)
-{
-    return lhs.x > rhs.x || lhs.y > rhs.y || lhs.z > rhs.z;
-}
-
-Vec3 operator+(const Vec3& lhs, const Vec3& rhs)
-{
-    return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
-}
-
-void add(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
-{
-    dst.x = lhs.x + rhs.x;
-    dst.y = lhs.y + rhs.y;
-    dst.z = lhs.z + rhs.z;
-}
-
-Vec3 operator-(const Vec3& lhs, const Vec3& rhs)
-{
-    return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
-}
-
-void sub(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
-{
-    dst.x = lhs.x - rhs.x;
-    dst.y = lhs.y - rhs.y;
-    dst.z = lhs.z - rhs.z;
-}
-
-Vec3 operator*(const Vec3& lhs, const Vec3& rhs)
-{
-    return {lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z};
-}
-
-void mul(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
-{
-    dst.x = lhs.x * rhs.x;
-    dst.y = lhs.y * rhs.y;
-    dst.z = lhs.z * rhs.z;
-}
-
-Vec3 operator*(float f, const Vec3& v)
-{
-    return Vec3(f * v.x, f * v.y, f * v.z);
-}
-
-Vec3 operator*(const Vec3& v, float f)
-{
-    return Vec3(f * v.x, f * v.y, f * v.z);
-}
-
-void mul(float f, const Vec3& v, Vec3& dst)
-{
-    dst.x = f * v.x;
-    dst.y = f * v.y;
-    dst.z = f * v.z;
-}
-
-void mul(const Vec3& v, float f, Vec3& dst)
-{
-    dst.x = f * v.x;
-    dst.y = f * v.y;
-    dst.z = f * v.z;
-}
-
-Vec3 operator/(const Vec3& lhs, const Vec3& rhs)
-{
-    return {lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z};
-}
-
-void div(const Vec3& lhs, const Vec3& rhs, Vec3& dst)
-{
-    dst.x = lhs.x / rhs.x;
-    dst.y = lhs.y / rhs.y;
-    dst.z = lhs.z / rhs.z;
-}
-
 float angle(const Vec3& v1, const Vec3& v2)
 {
     float dx = v1.y * v2.z - v1.z * v2.y;
@@ -817,37 +659,11 @@ void clamp(Vec3& v, const Vec3& min, const Vec3& max)
     clamp(v, min, max, v);
 }
 
-Vec3 cross(const Vec3& v1, const Vec3& v2)
-{
-    return {
-        v1.y * v2.z - v1.z * v2.y,
-        v1.z * v2.x - v1.x * v2.z,
-        v1.x * v2.y - v1.y * v2.x,
-    };
-}
-
-void cross(const Vec3& v1, const Vec3& v2, Vec3& dst)
-{
-    dst.x = v1.y * v2.z - v1.z * v2.y;
-    dst.y = v1.z * v2.x - v1.x * v2.z;
-    dst.z = v1.x * v2.y - v1.y * v2.x;
-}
-
-float dot(const Vec3& v1, const Vec3& v2)
-{
-    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-}
-
 float length(const Vec3& v)
 {
     return sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
 }
 
-float lengthSquared(const Vec3& v)
-{
-    return (v.x * v.x + v.y * v.y + v.z * v.z);
-}
-
 float distance(const Vec3& v1, const Vec3& v2)
 {
     float dx = v2.x - v1.x;
@@ -857,15 +673,6 @@ float distance(const Vec3& v1, const Vec3& v2)
     return sqrt(dx * dx + dy * dy + dz * dz);
 }
 
-float distanceSquared(const Vec3& v1, const Vec3& v2)
-{
-    float dx = v2.x - v1.x;
-    float dy = v2.y - v1.y;
-    float dz = v2.z - v1.z;
-
-    return (dx * dx + dy * dy + dz * dz);
-}
-
 Vec3 normalize(const Vec3& v)
 {
     const float invLen = 1.0f / length(v);
@@ -885,25 +692,6 @@ void normalize(Vec3& v)
     scale(v, invLen, v);
 }
 
-Vec3 scale(const Vec3& v, float scale)
-{
-    return {v.x * scale, v.y * scale, v.z * scale};
-}
-
-void scale(const Vec3& v, float scale, Vec3& dst)
-{
-    dst.x = v.x * scale;
-    dst.y = v.y * scale;
-    dst.z = v.z * scale;
-}
-
-void scale(Vec3& v, float scale)
-{
-    v.x = v.x * scale;
-    v.y = v.y * scale;
-    v.z = v.z * scale;
-}
-
 Vec3 minVec(const Vec3& v1, const Vec3& v2)
 {
     return Vec3(min(v1.x, v2.x), min(v1.y, v2.y), min(v1.z, v2.z));
@@ -964,88 +752,9 @@ Vec4::Vec4(const Vec3& v, float a)
 {
 }
 
-float& Vec4::operator[](size_t i)
-{
-    assert(i < 4);
-    return data[i];
-}
-
-const float& Vec4::operator[](size_t i) const
-{
-    assert(i < 4);
-    return data[i];
-}
-
 const Vec4 Vec4::Zero(0.f);
 const Vec4 Vec4::One(1.f);
 
-bool isZero(const Vec4& v)
-{
-    return v.x == 0.f && v.y == 0.f && v.z == 0.f && v.w == 0.f;
-}
-
-bool isOne(const Vec4& v)
-{
-    return v.x == 1.f && v.y == 1.f && v.z == 1.f && v.w == 1.f;
-}
-
-Vec4 operator-(const Vec4& v)
-{
-    return {-v.x, -v.y, -v.z, -v.w};
-}
-
-Vec4 operator+(const Vec4& lhs, const Vec4& rhs)
-{
-    return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
-}
-
-void add(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
-{
-    dst.x = lhs.x + rhs.x;
-    dst.y = lhs.y + rhs.y;
-    dst.z = lhs.z + rhs.z;
-    dst.w = lhs.w + rhs.w;
-}
-
-Vec4 operator-(const Vec4& lhs, const Vec4& rhs)
-{
-    return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
-}
-
-void sub(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
-{
-    dst.x = lhs.x - rhs.x;
-    dst.y = lhs.y - rhs.y;
-    dst.z = lhs.z - rhs.z;
-    dst.w = lhs.w - rhs.w;
-}
-
-Vec4 operator*(const Vec4& lhs, const Vec4& rhs)
-{
-    return {lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w};
-}
-
-void mul(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
-{
-    dst.x = lhs.x * rhs.x;
-    dst.y = lhs.y * rhs.y;
-    dst.z = lhs.z * rhs.z;
-    dst.w = lhs.w * rhs.w;
-}
-
-Vec4 operator/(const Vec4& lhs, const Vec4& rhs)
-{
-    return {lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z, lhs.w / rhs.w};
-}
-
-void div(const Vec4& lhs, const Vec4& rhs, Vec4& dst)
-{
-    dst.x = lhs.x / rhs.x;
-    dst.y = lhs.y / rhs.y;
-    dst.z = lhs.z / rhs.z;
-    dst.w = lhs.w / rhs.w;
-}
-
 float angle(const Vec4& v1, const Vec4& v2)
 {
     float dx = v1.w * v2.x - v1.x * v2.w - v1.y * v2.z + v1.z * v2.y;
@@ -1057,18 +766,21 @@ float angle(const Vec4& v1, const Vec4& v2)
 
 Vec4 clamp(const Vec4& v, const Vec4& min, const Vec4& max)
 {
-    return {clamp(v.x, min.x, max.x),  //
-            clamp(v.y, min.y, max.y),  //
-            clamp(v.z, min.z, max.z),  //
-            clamp(v.w, min.w, max.w)};
+    Vec4 result;
+    clamp(v, min, max, result);
+    return result;
 }
 
 void clamp(const Vec4& v, const Vec4& min, const Vec4& max, Vec4& dst)
 {
+#if HQ_MATH_SSE
+    store(_mm_min_ps(_mm_max_ps(load(v.data), load(min.data)), load(max.data)), dst.data);
+#else
     dst.x = clamp(v.x, min.x, max.x);
     dst.y = clamp(v.y, min.y, max.y);
     dst.z = clamp(v.z, min.z, max.z);
     dst.w = clamp(v.w, min.w, max.w);
+#endif
 }
 
 void clamp(Vec4& v, const Vec4& min, const Vec4& max)
@@ -1076,21 +788,11 @@ void clamp(Vec4& v, const Vec4& min, const Vec4& max)
     clamp(v, min, max, v);
 }
 
-float dot(const Vec4& v1, const Vec4& v2)
-{
-    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
-}
-
 float length(const Vec4& v)
 {
     return sqrt(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
 }
 
-float lengthSquared(const Vec4& v)
-{
-    return (v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
-}
-
 float distance(const Vec4& v1, const Vec4& v2)
 {
     float dx = v2.x - v1.x;
@@ -1101,67 +803,49 @@ float distance(const Vec4& v1, const Vec4& v2)
     return sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
 }
 
-float distanceSquared(const Vec4& v1, const Vec4& v2)
-{
-    float dx = v2.x - v1.x;
-    float dy = v2.y - v1.y;
-    float dz = v2.z - v1.z;
-    float dw = v2.w - v1.w;
-
-    return (dx * dx + dy * dy + dz * dz + dw * dw);
-}
-
 Vec4 normalize(const Vec4& v)
 {
-    const float invLen = 1.0f / length(v);
-    const Vec4  result = scale(v, invLen);
+    Vec4 result;
+    normalize(v, result);
     return result;
 }
 
 void normalize(const Vec4& v, Vec4& dst)
 {
+#if HQ_MATH_SSE
+    const __m128 x = load(v.data);
+    store(_mm_mul_ps(x, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot4(x, x)))), dst.data);
+#else
     const float invLen = 1.0f / length(v);
     scale(v, invLen, dst);
+#endif
 }
 
 void normalize(Vec4& v)
 {
-    const float invLen = 1.0f / length(v);
-    scale(v, invLen, v);
-}
-
-Vec4 scale(const Vec4& v, float scale)
-{
-    return {v.x * scale,  //
-            v.y * scale,  //
-            v.z * scale,  //
-            v.w * scale};
-}
-
-void scale(const Vec4& v, float scale, Vec4& dst)
-{
-    dst.x = v.x * scale;
-    dst.y = v.y * scale;
-    dst.z = v.z * scale;
-    dst.w = v.w * scale;
-}
-
-void scale(Vec4& v, float scale)
-{
-    v.x = v.x * scale;
-    v.y = v.y * scale;
-    v.z = v.z * scale;
-    v.w = v.w * scale;
+    normalize(v, v);
 }
 
 Vec4 minVec(const Vec4& v1, const Vec4& v2)
 {
+#if HQ_MATH_SSE
+    Vec4 result;
+    store(_mm_min_ps(load(v1.data), load(v2.data)), result.data);
+    return result;
+#else
     return Vec4(min(v1.x, v2.x), min(v1.y, v2.y), min(v1.z, v2.z), min(v1.w, v2.w));
+#endif
 }
 
 Vec4 maxVec(const Vec4& v1, const Vec4& v2)
 {
+#if HQ_MATH_SSE
+    Vec4 result;
+    store(_mm_max_ps(load(v1.data), load(v2.data)), result.data);
+    return result;
+#else
     return Vec4(max(v1.x, v2.x), max(v1.y, v2.y), max(v1.z, v2.z), max(v1.w, v2.w));
+#endif
 }
 
 float maxComponent(const Vec4& v)
@@ -1537,6 +1221,11 @@ void setIdentity(Mat4x4& dst)
 
 void mul(const Mat4x4& matrix, float scalar, Mat4x4& dst)
 {
+#if HQ_MATH_SSE
+    const __m128 s = _mm_set1_ps(scalar);
+    for (int i = 0; i < 16; i += 4)
+        store(_mm_mul_ps(load(matrix.data + i), s), dst.data + i);
+#else
     float*       d = dst.data;
     const float* m = matrix.data;
     d[0]           = m[0] * scalar;
@@ -1555,13 +1244,86 @@ void mul(const Mat4x4& matrix, float scalar, Mat4x4& dst)
     d[13]          = m[13] * scalar;
     d[14]          = m[14] * scalar;
     d[15]          = m[15] * scalar;
+#endif
 }
 
+#if HQ_MATH_AVX
+namespace
+{
+    // columns of lhs broadcast in both halves
+    struct Columns
+    {
+        __m256 c0, c1, c2, c3;
+
+        explicit Columns(const float* m1)
+            : c0(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(m1)))
+            , c1(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(m1 + 4)))
+            , c2(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(m1 + 8)))
+            , c3(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(m1 + 12)))
+        {
+        }
+    };
+
+    inline __m256 madd(__m256 a, __m256 b, __m256 c)
+    {
+#if HQ_MATH_FMA
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    // two columns of the result, each half weighted by its own column of rhs
+    inline __m256 combineColumns(const Columns& lhs, __m256 r)
+    {
+        __m256 v = _mm256_mul_ps(lhs.c0, _mm256_permute_ps(r, 0x00));
+        v        = madd(lhs.c1, _mm256_permute_ps(r, 0x55), v);
+        v        = madd(lhs.c2, _mm256_permute_ps(r, 0xaa), v);
+        return madd(lhs.c3, _mm256_permute_ps(r, 0xff), v);
+    }
+
+    // rhs is read before d is written so rhs and d can alias
+    inline void mulColumns(const Columns& lhs, const float* m2, float* d)
+    {
+        const __m256 r01 = _mm256_loadu_ps(m2);
+        const __m256 r23 = _mm256_loadu_ps(m2 + 8);
+        _mm256_storeu_ps(d, combineColumns(lhs, r01));
+        _mm256_storeu_ps(d + 8, combineColumns(lhs, r23));
+    }
+}  // namespace
+#elif HQ_MATH_SSE
+namespace
+{
+    // column j of the result is the combination of the columns of lhs weighted by column j of rhs,
+    // each column of rhs is read before the same column of d is written so rhs and d can alias
+    inline void mulColumns(__m128 c0, __m128 c1, __m128 c2, __m128 c3, const float* m2, float* d)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            const __m128 r = load(m2 + j * 4);
+            __m128       v = _mm_mul_ps(c0, swizzle<0, 0, 0, 0>(r));
+            v              = madd(c1, swizzle<1, 1, 1, 1>(r), v);
+            v              = madd(c2, swizzle<2, 2, 2, 2>(r), v);
+            v              = madd(c3, swizzle<3, 3, 3, 3>(r), v);
+            store(v, d + j * 4);
+        }
+    }
+}  // namespace
+#endif
+
 void mul(const Mat4x4& lhs, const Mat4x4& rhs, Mat4x4& dst)
 {
+#if HQ_MATH_AVX
+    mulColumns(Columns(lhs.data), rhs.data, dst.data);
+#elif HQ_MATH_SSE
+    const float* m1 = lhs.data;
+    mulColumns(load(m1), load(m1 + 4), load(m1 + 8), load(m1 + 12), rhs.data, dst.data);
+#else
+    // computed aside so dst can alias lhs or rhs, like the SIMD paths
     const float* m1 = lhs.data;
     const float* m2 = rhs.data;
-    float*       d  = dst.data;
+    Mat4x4       result;
+    float*       d = result.data;
 
     d[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
     d[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
@@ -1582,6 +1344,28 @@ void mul(const Mat4x4& lhs, const Mat4x4& rhs, Mat4x4& dst)
     d[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[9] * m2[14] + m1[13] * m2[15];
     d[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
     d[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
+    dst   = result;
+#endif
+}
+
+void mul(const Mat4x4& lhs, const Mat4x4* rhs, Mat4x4* dst, size_t count)
+{
+#if HQ_MATH_AVX
+    const Columns columns(lhs.data);
+    for (size_t i = 0; i < count; ++i)
+        mulColumns(columns, rhs[i].data, dst[i].data);
+#elif HQ_MATH_SSE
+    const float* m1 = lhs.data;
+    const __m128 c0 = load(m1);
+    const __m128 c1 = load(m1 + 4);
+    const __m128 c2 = load(m1 + 8);
+    const __m128 c3 = load(m1 + 12);
+    for (size_t i = 0; i < count; ++i)
+        mulColumns(c0, c1, c2, c3, rhs[i].data, dst[i].data);
+#else
+    for (size_t i = 0; i < count; ++i)
+        mul(lhs, rhs[i], dst[i]);
+#endif
 }
 
 void mul(Mat4x4& lhs, const Mat4x4& rhs)
@@ -2195,8 +1979,87 @@ bool canInvert(const Mat4x4& matrix)
     return determinant(matrix) > kFloatTolerance;
 }
 
+#if HQ_MATH_SSE
+namespace
+{
+    // 2x2 matrices in a vector (m00, m01, m10, m11)
+    // a * b
+    inline __m128 mat2Mul(__m128 a, __m128 b)
+    {
+        return madd(a, swizzle<0, 3, 0, 3>(b), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+
+    // adjugate(a) * b
+    inline __m128 mat2AdjMul(__m128 a, __m128 b)
+    {
+        return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(a), b),
+                          _mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+    }
+
+    // a * adjugate(b)
+    inline __m128 mat2MulAdj(__m128 a, __m128 b)
+    {
+        return _mm_sub_ps(_mm_mul_ps(a, swizzle<3, 0, 3, 0>(b)),
+                          _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+}  // namespace
+#endif
+
 void invert(const Mat4x4& matrix, Mat4x4& dst)
 {
+#if HQ_MATH_SSE
+    // block inversion of | A B |, the columns are used as rows: the inverse of the transpose is the transpose of the
+    //                    | C D |  inverse, so the result comes out in columns too
+    // https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+    const __m128 r0 = load(matrix.data);
+    const __m128 r1 = load(matrix.data + 4);
+    const __m128 r2 = load(matrix.data + 8);
+    const __m128 r3 = load(matrix.data + 12);
+
+    const __m128 a = _mm_movelh_ps(r0, r1);
+    const __m128 b = _mm_movehl_ps(r1, r0);
+    const __m128 c = _mm_movelh_ps(r2, r3);
+    const __m128 d = _mm_movehl_ps(r3, r2);
+
+    // |A| |B| |C| |D|
+    const __m128 detSub = _mm_sub_ps(_mm_mul_ps(shuffle<0, 2, 0, 2>(r0, r2), shuffle<1, 3, 1, 3>(r1, r3)),
+                                     _mm_mul_ps(shuffle<1, 3, 1, 3>(r0, r2), shuffle<0, 2, 0, 2>(r1, r3)));
+    const __m128 detA   = swizzle<0, 0, 0, 0>(detSub);
+    const __m128 detB   = swizzle<1, 1, 1, 1>(detSub);
+    const __m128 detC   = swizzle<2, 2, 2, 2>(detSub);
+    const __m128 detD   = swizzle<3, 3, 3, 3>(detSub);
+
+    const __m128 dc = mat2AdjMul(d, c);
+    const __m128 ab = mat2AdjMul(a, b);
+    // adjugates of the blocks of the inverse: X = |D|A - B(D#C), W = |A|D - C(A#B), Y = |B|C - D(A#B)#,
+    // Z = |C|B - A(D#C)#
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mat2Mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mat2Mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mat2MulAdj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mat2MulAdj(a, dc));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    const __m128 trace = sum(_mm_mul_ps(ab, swizzle<0, 2, 1, 3>(dc)));
+    const __m128 det   = _mm_sub_ps(madd(detA, detD, _mm_mul_ps(detB, detC)), trace);
+    // Close to zero, can't invert.
+    if (abs(_mm_cvtss_f32(det)) <= kFloatTolerance)
+    {
+        printf("Determinant close to zero, can't invert matrix");
+        abort();
+    }
+
+    const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    x                   = _mm_mul_ps(x, invDet);
+    y                   = _mm_mul_ps(y, invDet);
+    z                   = _mm_mul_ps(z, invDet);
+    w                   = _mm_mul_ps(w, invDet);
+
+    // adjugate shuffle and store shuffle combined
+    store(shuffle<3, 1, 3, 1>(x, y), dst.data);
+    store(shuffle<2, 0, 2, 0>(x, y), dst.data + 4);
+    store(shuffle<3, 1, 3, 1>(z, w), dst.data + 8);
+    store(shuffle<2, 0, 2, 0>(z, w), dst.data + 12);
+#else
     const float* m  = matrix.data;
     float        a0 = m[0] * m[5] - m[1] * m[4];
     float        a1 = m[0] * m[6] - m[2] * m[4];
@@ -2243,6 +2106,7 @@ void invert(const Mat4x4& matrix, Mat4x4& dst)
     inverse.data[15] = m[8] * a3 - m[9] * a1 + m[10] * a0;
 
     mul(inverse, 1.0f / det, dst);
+#endif
 }
 
 void invert(Mat4x4& matrix)
@@ -2360,6 +2224,13 @@ void scale(Mat4x4& matrix, const Vec3& s)
 
 void transform(const Vec4& vec, const Mat4x4& matrix, Vec3& dst)
 {
+#if HQ_MATH_SSE
+    float result[4];
+    store(combineColumns(matrix.data, load(vec.data)), result);
+    dst.data[0] = result[0];
+    dst.data[1] = result[1];
+    dst.data[2] = result[2];
+#else
     const float* v = vec.data;
     const float* m = matrix.data;
     // Handle case where v == dst.
@@ -2370,6 +2241,7 @@ void transform(const Vec4& vec, const Mat4x4& matrix, Vec3& dst)
     dst.data[0] = x;
     dst.data[1] = y;
     dst.data[2] = z;
+#endif
 }
 
 void transformPoint(const Vec3& point, const Mat4x4& matrix, Vec3& dst)
@@ -2394,6 +2266,9 @@ void transform(Vec3& v, const Mat4x4& matrix)
 
 void transform(const Vec4& vec, const Mat4x4& matrix, Vec4& dst)
 {
+#if HQ_MATH_SSE
+    store(combineColumns(matrix.data, load(vec.data)), dst.data);
+#else
     const float* v = vec.data;
     const float* m = matrix.data;
     // Handle case where v == dst.
@@ -2406,6 +2281,7 @@ void transform(const Vec4& vec, const Mat4x4& matrix, Vec4& dst)
     dst.data[1] = y;
     dst.data[2] = z;
     dst.data[3] = w;
+#endif
 }
 
 void transform(Vec4& v, const Mat4x4& matrix)
@@ -2441,10 +2317,22 @@ void translate(Mat4x4& matrix, float x, float y, float z)
 
 void transpose(const Mat4x4& matrix, Mat4x4& dst)
 {
+#if HQ_MATH_SSE
+    __m128 c0 = load(matrix.data);
+    __m128 c1 = load(matrix.data + 4);
+    __m128 c2 = load(matrix.data + 8);
+    __m128 c3 = load(matrix.data + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    store(c0, dst.data);
+    store(c1, dst.data + 4);
+    store(c2, dst.data + 8);
+    store(c3, dst.data + 12);
+#else
     const float* m     = matrix.data;
     float        t[16] = {m[0], m[4], m[8],  m[12], m[1], m[5], m[9],  m[13],
                    m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]};
     memcpy(&dst, t, sizeof(dst));
+#endif
 }
 
 void transpose(Mat4x4& matrix)
@@ -2725,6 +2613,16 @@ Quat operator*(const Quat& q1, const Quat& q2)
 
 void mul(const Quat& q1, const Quat& q2, Quat& dst)
 {
+#if HQ_MATH_SSE
+    // q1.w * q2 + q1.x * (w, -z, y, -x) + q1.y * (z, w, -x, -y) + q1.z * (-y, x, w, -z)
+    const __m128 a = load(q1.data);
+    const __m128 b = load(q2.data);
+    __m128       r = _mm_mul_ps(swizzle<3, 3, 3, 3>(a), b);
+    r = madd(swizzle<0, 0, 0, 0>(a), negate(swizzle<3, 2, 1, 0>(b), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f)), r);
+    r = madd(swizzle<1, 1, 1, 1>(a), negate(swizzle<2, 3, 0, 1>(b), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f)), r);
+    r = madd(swizzle<2, 2, 2, 2>(a), negate(swizzle<1, 0, 3, 2>(b), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f)), r);
+    store(r, dst.data);
+#else
     float x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
     float y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
     float z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
@@ -2734,6 +2632,7 @@ void mul(const Quat& q1, const Quat& q2, Quat& dst)
     dst.y = y;
     dst.z = z;
     dst.w = w;
+#endif
 }
 
 Quat normalize(const Quat& q)
@@ -2749,18 +2648,28 @@ void normalize(const Quat& q, Quat& dst)
 
     // Already normalized.
     if (n == 1.0f)
+    {
+        dst = q;
         return;
+    }
 
     n = sqrt(n);
     // Too close to zero.
     if (n < 0.000001f)
+    {
+        dst = q;
         return;
+    }
 
-    n     = 1.0f / n;
+    n = 1.0f / n;
+#if HQ_MATH_SSE
+    store(_mm_mul_ps(load(q.data), _mm_set1_ps(n)), dst.data);
+#else
     dst.x = q.x * n;
     dst.y = q.y * n;
     dst.z = q.z * n;
     dst.w = q.w * n;
+#endif
 }
 
 void normalize(Quat& q)
@@ -2837,10 +2746,14 @@ void lerp(const Quat& q1, const Quat& q2, float t, Quat& dst)
 
     float t1 = 1.0f - t;
 
+#if HQ_MATH_SSE
+    store(madd(_mm_set1_ps(t1), load(q1.data), _mm_mul_ps(_mm_set1_ps(t), load(q2.data))), dst.data);
+#else
     dst.x = t1 * q1.x + t * q2.x;
     dst.y = t1 * q1.y + t * q2.y;
     dst.z = t1 * q1.z + t * q2.z;
     dst.w = t1 * q1.w + t * q2.w;
+#endif
 }
 
 Quat slerp(const Quat& q1, const Quat& q2, float t)
@@ -2933,6 +2846,11 @@ void slerp(const Quat& q1, const Quat& q2, float t, Quat& dst)
     alpha *= f1 + f2a;
     beta = f1 + f2b;
 
+#if HQ_MATH_SSE
+    // Apply final coefficients to a and b as usual, then correct the length like below.
+    const __m128 q = madd(_mm_set1_ps(alpha), load(q1.data), _mm_mul_ps(_mm_set1_ps(beta), load(q2.data)));
+    store(_mm_mul_ps(q, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_set1_ps(0.5f), dot4(q, q)))), dst.data);
+#else
     // Apply final coefficients to a and b as usual.
     float w = alpha * q1.w + beta * q2.w;
     float x = alpha * q1.x + beta * q2.x;
@@ -2949,6 +2867,7 @@ void slerp(const Quat& q1, const Quat& q2, float t, Quat& dst)
     dst.x = x * f1;
     dst.y = y * f1;
     dst.z = z * f1;
+#endif
 }
 
 void slerpForSquad(const Quat& q1, const Quat& q2, float t, Quat& dst)
@@ -1,8 +1,15 @@
 #include "Hq/StringHash.h"
 #include "Hq/BasicTypes.h"
+#ifdef HQ_STRING_INTERNING
+#include "Hq/StringTable.h"
+#endif
 
 #include <cstring>
 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
 namespace hq
 {
 u32 MurmurHash3_32(const void* key, uint len, u32 seed)
@@ -62,24 +69,141 @@ u32 MurmurHash3_32(const void* key, uint len, u32 seed)
     return fmix32(h1);
 }
 
-StringHash::StringHash()
-    : _hash(0)
+namespace
+{
+const u64 kWySecret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// 64x64 -> 128 bits multiply, low half in a and high half in b
+inline void wymum(u64* a, u64* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *a;
+    r *= *b;
+    *a = static_cast<u64>(r);
+    *b = static_cast<u64>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    const u64 ha = *a >> 32, hb = *b >> 32, la = static_cast<u32>(*a), lb = static_cast<u32>(*b);
+    const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+    u64       c  = t < rl;
+    const u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline u64 wymix(u64 a, u64 b)
+{
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+inline u64 wyr8(const u8* p)
+{
+    u64 v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline u64 wyr4(const u8* p)
+{
+    u32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline u64 wyr3(const u8* p, size_t k)
+{
+    return (static_cast<u64>(p[0]) << 16) | (static_cast<u64>(p[k >> 1]) << 8) | p[k - 1];
+}
+}  // namespace
+
+u64 WyHash64(const void* key, size_t len, u64 seed)
+{
+    const u8* p = static_cast<const u8*>(key);
+    seed ^= wymix(seed ^ kWySecret[0], kWySecret[1]);
+    u64 a, b;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+            b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = wyr3(p, len);
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            // three independent lanes so the multiplies of a block overlap
+            u64 see1 = seed, see2 = seed;
+            do
+            {
+                seed = wymix(wyr8(p) ^ kWySecret[1], wyr8(p + 8) ^ seed);
+                see1 = wymix(wyr8(p + 16) ^ kWySecret[2], wyr8(p + 24) ^ see1);
+                see2 = wymix(wyr8(p + 32) ^ kWySecret[3], wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = wymix(wyr8(p) ^ kWySecret[1], wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyr8(p + i - 16);
+        b = wyr8(p + i - 8);
+    }
+
+    a ^= kWySecret[1];
+    b ^= seed;
+    wymum(&a, &b);
+    return wymix(a ^ kWySecret[0] ^ len, b ^ kWySecret[1]);
+}
+
+size_t hashString(const char* str, size_t len)
+{
+#ifdef HQ_STRING_HASH_64
+    return static_cast<size_t>(WyHash64(str, len, kStringHashSeed));
+#else
+    return MurmurHash3_32(str, static_cast<uint>(len), kStringHashSeed);
+#endif
+}
+
+void hashMany(Span<const std::string_view> strings, StringHash* hashes)
 {
+    for (size_t i = 0; i < strings.size(); ++i)
+        hashes[i] = StringHash(strings[i]);
 }
 
 StringHash::StringHash(const char* str)
-    : _hash(MurmurHash3_32(str, static_cast<uint>(strlen(str)), 0x12345678))
+    : StringHash(std::string_view(str))
 {
 }
 
 StringHash::StringHash(const std::string& str)
-    : _hash(MurmurHash3_32(str.c_str(), static_cast<uint>(str.length()), 0x12345678))
+    : StringHash(std::string_view(str))
 {
 }
 
-size_t StringHash::hash() const
+StringHash::StringHash(std::string_view str)
+    : _hash(hashString(str.data(), str.length()))
 {
-    return _hash;
+#ifdef HQ_STRING_INTERNING
+    StringTable::global().intern(str, *this);
+#endif
 }
 
 }  // atlas namespace
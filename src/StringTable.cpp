@@ -0,0 +1,173 @@
+#include "Hq/StringTable.h"
+#include "Hq/BinarySerializer.h"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace hq
+{
+namespace
+{
+const u32 kStringTableMagic   = 0x54535148;  // "HQST"
+const u32 kStringTableVersion = 1;
+}  // namespace
+
+const char* StringTable::Shard::store(std::string_view str)
+{
+    const size_t size = str.size() + 1;
+    char*        dst;
+    if (size > kArenaBlockSize / 4)
+    {
+        // big strings get their own block, the current one stays open for small strings
+        blocks.emplace_back(new char[size]);
+        dst = blocks.back().get();
+        if (blocks.size() > 1)
+            std::swap(blocks.back(), blocks[blocks.size() - 2]);
+    }
+    else
+    {
+        if (blockUsed + size > kArenaBlockSize)
+        {
+            blocks.emplace_back(new char[kArenaBlockSize]);
+            blockUsed = 0;
+        }
+        dst = blocks.back().get() + blockUsed;
+        blockUsed += size;
+    }
+
+    memcpy(dst, str.data(), str.size());
+    dst[str.size()] = '\0';
+    return dst;
+}
+
+StringTable& StringTable::global()
+{
+    static StringTable table;
+    return table;
+}
+
+bool StringTable::intern(std::string_view str)
+{
+    return intern(str, StringHash::fromHash(hashString(str.data(), str.size())));
+}
+
+bool StringTable::intern(std::string_view str, StringHash hash)
+{
+    Shard& s = shard(hash);
+    s.lock.lock();
+
+    auto it = s.strings.find(hash);
+    if (it == s.strings.end())
+    {
+        s.strings.try_emplace(hash, Entry {s.store(str), static_cast<u32>(str.size())});
+        s.lock.unlock();
+        return true;
+    }
+
+    const Entry entry = it->second;
+    s.lock.unlock();
+
+    if (std::string_view(entry.str, entry.length) == str)
+        return true;
+
+    _collisions.fetch_add(1, std::memory_order_relaxed);
+    if (CollisionHandler handler = _collisionHandler.load(std::memory_order_acquire))
+        handler(hash, entry.str, str);
+    return false;
+}
+
+const char* StringTable::lookup(StringHash hash) const
+{
+    const Shard& s = shard(hash);
+    s.lock.lock();
+    auto        it  = s.strings.find(hash);
+    const char* str = it != s.strings.end() ? it->second.str : nullptr;
+    s.lock.unlock();
+    return str;
+}
+
+size_t StringTable::size() const
+{
+    size_t count = 0;
+    for (const Shard& s : _shards)
+    {
+        s.lock.lock();
+        count += s.strings.size();
+        s.lock.unlock();
+    }
+    return count;
+}
+
+size_t StringTable::collisionCount() const
+{
+    return _collisions.load(std::memory_order_relaxed);
+}
+
+void StringTable::setCollisionHandler(CollisionHandler handler)
+{
+    _collisionHandler.store(handler, std::memory_order_release);
+}
+
+void StringTable::clear()
+{
+    for (Shard& s : _shards)
+    {
+        s.lock.lock();
+        s.strings.clear();
+        s.blocks.clear();
+        s.blockUsed = kArenaBlockSize;
+        s.lock.unlock();
+    }
+    _collisions.store(0, std::memory_order_relaxed);
+}
+
+void StringTable::save(std::ostream& out) const
+{
+    BinarySerializer serializer(out);
+    serializer(kStringTableMagic);
+    serializer(kStringTableVersion);
+    serializer(kStringHashBits);
+
+    for (const Shard& s : _shards)
+    {
+        s.lock.lock();
+        serializer(static_cast<u64>(s.strings.size()));
+        for (const auto& entry : s.strings)
+        {
+            serializer(static_cast<u64>(entry.first.hash()));
+            serializer(std::string(entry.second.str, entry.second.length));
+        }
+        s.lock.unlock();
+    }
+}
+
+bool StringTable::load(std::istream& in)
+{
+    BinaryDeserializer deserializer(in);
+    u32                magic = 0, version = 0, hashBits = 0;
+    deserializer(magic);
+    deserializer(version);
+    deserializer(hashBits);
+    if (!in || magic != kStringTableMagic || version != kStringTableVersion || hashBits != kStringHashBits)
+        return false;
+
+    std::string str;
+    for (u32 i = 0; i < kShardCount; ++i)
+    {
+        u64 count = 0;
+        deserializer(count);
+        for (u64 j = 0; j < count && in; ++j)
+        {
+            u64 hash = 0;
+            deserializer(hash);
+            deserializer(str);
+            if (in)
+                intern(str, StringHash::fromHash(static_cast<size_t>(hash)));
+        }
+    }
+
+    return static_cast<bool>(in);
+}
+}  // namespace hq
@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#include "Hq/FreelistAllocator.h"
+#include "Hq/GuardedAllocator.h"
+
+#include <cstring>
+#include <vector>
+
+TEST_CASE("GuardedAllocator alloc and free", "[allocator]")
+{
+    GuardedAllocator allocator(1024, 0);
+
+    void* small   = allocator.allocate(3, 1);
+    void* aligned = allocator.allocate(100, 16);
+    REQUIRE(small != nullptr);
+    REQUIRE(aligned != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 16 == 0);
+    REQUIRE(allocator.getUsedMemory() == 103);
+    REQUIRE(allocator.getNumAllocations() == 2);
+
+    // the whole block is writable, up to the guard page
+    std::memset(small, 0xab, 3);
+    std::memset(aligned, 0xcd, 100);
+    REQUIRE(static_cast<u8*>(small)[2] == 0xab);
+    REQUIRE(static_cast<u8*>(aligned)[99] == 0xcd);
+
+    // over the size budget
+    REQUIRE(allocator.allocate(1024, 4) == nullptr);
+
+    allocator.deallocate(small);
+    allocator.deallocate(aligned);
+    REQUIRE(allocator.getUsedMemory() == 0);
+    REQUIRE(allocator.getNumAllocations() == 0);
+    REQUIRE(allocator.getQuarantinedCount() == 0);
+}
+
+TEST_CASE("GuardedAllocator quarantine eviction", "[allocator]")
+{
+    constexpr size_t kQuarantineSize = 4;
+    GuardedAllocator allocator(1 << 20, kQuarantineSize);
+
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < 2 * kQuarantineSize; ++i)
+        blocks.push_back(allocator.allocate(64, 8));
+
+    for (size_t i = 0; i < kQuarantineSize; ++i)
+    {
+        allocator.deallocate(blocks[i]);
+        REQUIRE(allocator.getQuarantinedCount() == i + 1);
+    }
+
+    // the oldest blocks are released to make room, the quarantine stays full
+    for (size_t i = kQuarantineSize; i < blocks.size(); ++i)
+    {
+        allocator.deallocate(blocks[i]);
+        REQUIRE(allocator.getQuarantinedCount() == kQuarantineSize);
+    }
+    REQUIRE(allocator.getUsedMemory() == 0);
+    REQUIRE(allocator.getNumAllocations() == 0);
+
+    // allocating again after evictions still works
+    void* p = allocator.allocate(64, 8);
+    REQUIRE(p != nullptr);
+    allocator.deallocate(p);
+}
+
+TEST_CASE("GuardedAllocator created in a parent allocator", "[allocator]")
+{
+    std::vector<u8>   memory(4096);
+    FreeListAllocator parent(memory.size(), memory.data());
+
+    GuardedAllocator* allocator = allocator::newGuardedAllocator(1024, parent, 2);
+    for (int i = 0; i < 3; ++i)
+        allocator->deallocate(allocator->allocate(16, 4));
+    REQUIRE(allocator->getQuarantinedCount() == 2);
+
+    allocator::deleteGuardedAllocator(*allocator, parent);
+    REQUIRE(parent.getNumAllocations() == 0);
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+#include "Hq/FlatHashMap.h"
+#include "Hq/FreelistAllocator.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace hq;
+
+TEST_CASE("FlatHashMap matches std::unordered_map", "[flathashmap]")
+{
+    FlatHashMap<u32, u32>        map;
+    std::unordered_map<u32, u32> reference;
+    std::mt19937                 rng(42);
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        // small key range so inserts, updates and erases hit the same keys and leave tombstones
+        const u32 key = rng() % 4096;
+        switch (rng() % 4)
+        {
+            case 0:
+            case 1:
+                map[key]       = static_cast<u32>(i);
+                reference[key] = static_cast<u32>(i);
+                break;
+            case 2:
+                REQUIRE(map.erase(key) == reference.erase(key));
+                break;
+            case 3:
+            {
+                auto it  = map.find(key);
+                auto ref = reference.find(key);
+                REQUIRE((it == map.end()) == (ref == reference.end()));
+                if (ref != reference.end())
+                    REQUIRE(it->second == ref->second);
+                break;
+            }
+        }
+        REQUIRE(map.size() == reference.size());
+    }
+
+    size_t visited = 0;
+    for (const auto& entry : map)
+    {
+        REQUIRE(reference.at(entry.first) == entry.second);
+        ++visited;
+    }
+    REQUIRE(visited == reference.size());
+
+    FlatHashMap<u32, u32> copy = map;
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(copy.size() == reference.size());
+    for (const auto& entry : reference)
+        REQUIRE(copy.at(entry.first) == entry.second);
+}
+
+TEST_CASE("FlatHashMap with prehashed keys", "[flathashmap]")
+{
+    FlatHashMap<StringHash, std::string> names;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const std::string name = "resource_" + std::to_string(i);
+        REQUIRE(names.try_emplace(StringHash(name), name).second);
+    }
+    REQUIRE(!names.try_emplace(StringHash("resource_10"), "other").second);
+    REQUIRE(names.at(StringHash("resource_10")) == "resource_10");
+    REQUIRE(!names.contains(StringHash("resource_1000")));
+
+    using H = Handle<20, 12>;
+    FlatHashSet<H> handles;
+    for (u32 i = 0; i < 10000; ++i)
+        handles.insert(H(i, 1));
+    REQUIRE(handles.size() == 10000);
+    REQUIRE(handles.contains(H(42, 1)));
+    REQUIRE(!handles.contains(H(42, 2)));
+    for (u32 i = 0; i < 10000; i += 2)
+        REQUIRE(handles.erase(H(i, 1)) == 1);
+    REQUIRE(handles.size() == 5000);
+    REQUIRE(!handles.contains(H(42, 1)));
+    REQUIRE(handles.contains(H(43, 1)));
+}
+
+TEST_CASE("FlatHashMap in an arena", "[flathashmap]")
+{
+    std::vector<u8>   memory(1 << 20);
+    FreeListAllocator arena(memory.size(), memory.data());
+    {
+        using Alloc = StdAllocatorAdapter<std::pair<u32, float>>;
+        FlatHashMap<u32, float, FlatHash<u32>, std::equal_to<u32>, Alloc> map {Alloc(arena)};
+        for (u32 i = 0; i < 5000; ++i)
+            map[i] = static_cast<float>(i);
+        REQUIRE(arena.getNumAllocations() == 2);
+        REQUIRE(map.at(4999) == 4999.f);
+    }
+    REQUIRE(arena.getNumAllocations() == 0);
+}
@@ -0,0 +1,512 @@
+#include "catch.hpp"
+#include "Hq/ChunkedFreeList.h"
+#include "Hq/ConcurrentFreeList.h"
+#include "Hq/DynFreeList.h"
+#include "Hq/FreeList.h"
+#include "Hq/SoAFreeList.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+using TestHandle = Handle<20, 12>;
+
+struct Item
+{
+    u32 value {0};
+};
+
+constexpr size_t kStorageSize = 1024;
+constexpr size_t kOperations  = 20000;
+
+// checks the handle round trip and stale handle detection of any free list container
+template <typename Storage>
+void checkHandles(Storage& storage)
+{
+    auto first   = storage.alloc();
+    auto second  = storage.alloc();
+    auto removed = first;
+
+    REQUIRE(storage.isValid(first));
+    REQUIRE(storage.isValid(second));
+    REQUIRE(first != second);
+
+    storage.remove(first);
+    REQUIRE(!storage.isValid(removed));
+    REQUIRE(storage.isValid(second));
+
+    // the slot is reused with a new generation
+    auto third = storage.alloc();
+    REQUIRE(third.index() == removed.index());
+    REQUIRE(third.generation() != removed.generation());
+    REQUIRE(!storage.isValid(removed));
+    REQUIRE(storage.isValid(third));
+}
+}  // namespace
+
+TEST_CASE("DynFreeList matches FreeList", "[freelist]")
+{
+    auto                          fixed = std::make_unique<FreeList<Item, TestHandle, kStorageSize, true>>();
+    DynFreeList<Item, TestHandle> dynamic;
+    std::vector<TestHandle>       handles;
+    std::mt19937                  rng(42);
+
+    for (size_t i = 0; i < kOperations; ++i)
+    {
+        const bool add = handles.empty() || (handles.size() < kStorageSize && rng() % 3 != 0);
+        if (add)
+        {
+            TestHandle fixedHandle   = fixed->alloc();
+            TestHandle dynamicHandle = dynamic.alloc();
+            REQUIRE(fixedHandle == dynamicHandle);
+            fixed->getRef(fixedHandle).value     = static_cast<u32>(i);
+            dynamic.getRef(dynamicHandle).value = static_cast<u32>(i);
+            handles.push_back(dynamicHandle);
+        }
+        else
+        {
+            const size_t     index  = rng() % handles.size();
+            const TestHandle handle = handles[index];
+            REQUIRE(fixed->getRef(handle).value == dynamic.getRef(handle).value);
+            fixed->remove(handle);
+            dynamic.remove(handle);
+            REQUIRE(!fixed->isValid(handle));
+            REQUIRE(!dynamic.isValid(handle));
+            REQUIRE(dynamic.get(handle) == nullptr);
+            handles[index] = handles.back();
+            handles.pop_back();
+        }
+    }
+
+    for (const TestHandle& handle : handles)
+        REQUIRE(fixed->getRef(handle).value == dynamic.getRef(handle).value);
+}
+
+TEST_CASE("DynPackedFreeList matches PackedFreeList", "[freelist]")
+{
+    auto fixed                          = std::make_unique<PackedFreeList<Item, TestHandle, kStorageSize, true>>();
+    DynPackedFreeList<Item, TestHandle> dynamic(16);
+    std::vector<TestHandle>             handles;
+    std::mt19937                        rng(42);
+
+    for (size_t i = 0; i < kOperations; ++i)
+    {
+        const bool add = handles.empty() || (handles.size() < kStorageSize && rng() % 3 != 0);
+        if (add)
+        {
+            TestHandle fixedHandle   = fixed->alloc();
+            TestHandle dynamicHandle = dynamic.alloc();
+            REQUIRE(fixedHandle == dynamicHandle);
+            fixed->getRef(fixedHandle).value     = static_cast<u32>(i);
+            dynamic.getRef(dynamicHandle).value = static_cast<u32>(i);
+            handles.push_back(dynamicHandle);
+        }
+        else
+        {
+            const size_t     index  = rng() % handles.size();
+            const TestHandle handle = handles[index];
+            fixed->remove(handle);
+            dynamic.remove(handle);
+            REQUIRE(!dynamic.isValid(handle));
+            handles[index] = handles.back();
+            handles.pop_back();
+        }
+
+        REQUIRE(dynamic.size() == fixed->storage().count);
+    }
+
+    // same packed layout
+    for (u32 i = 0; i < dynamic.size(); ++i)
+    {
+        REQUIRE(dynamic.packedStorage()[i].value == fixed->storage().array[i].value);
+        REQUIRE(dynamic.getHandleFromPackedIndex(i) == fixed->getHandleFromPackedIndex(i));
+    }
+
+    dynamic.shrink_to_fit();
+    for (const TestHandle& handle : handles)
+        REQUIRE(fixed->getRef(handle).value == dynamic.getRef(handle).value);
+
+    dynamic.clear();
+    REQUIRE(dynamic.size() == 0);
+    REQUIRE(dynamic.alloc() == TestHandle(0, 1));
+}
+
+TEST_CASE("Packed free lists batch operations", "[freelist]")
+{
+    auto                                batched = std::make_unique<PackedFreeList<Item, TestHandle, kStorageSize, true>>();
+    DynPackedFreeList<Item, TestHandle> dynamic;
+    std::vector<TestHandle>             handles(kStorageSize);
+    std::vector<TestHandle>             dynamicHandles(kStorageSize);
+
+    REQUIRE(batched->allocN(handles.data(), kStorageSize + 1) == kStorageSize);
+    dynamic.allocN(dynamicHandles.data(), kStorageSize);
+    REQUIRE(handles == dynamicHandles);
+
+    for (u32 i = 0; i < kStorageSize; ++i)
+    {
+        batched->getRef(handles[i]).value = i;
+        dynamic.getRef(handles[i]).value  = i;
+    }
+
+    // remove every third object, with duplicates
+    std::vector<TestHandle> removed;
+    for (u32 i = 0; i < kStorageSize; i += 3)
+        removed.push_back(handles[i]);
+    removed.push_back(handles[0]);
+
+    batched->removeN(removed);
+    dynamic.removeN(removed);
+    REQUIRE(batched->storage().count == kStorageSize - (removed.size() - 1));
+    REQUIRE(dynamic.size() == batched->storage().count);
+
+    for (u32 i = 0; i < kStorageSize; ++i)
+    {
+        const bool alive = (i % 3) != 0;
+        REQUIRE(batched->isValid(handles[i]) == alive);
+        REQUIRE(dynamic.isValid(handles[i]) == alive);
+        if (alive)
+        {
+            REQUIRE(batched->getRef(handles[i]).value == i);
+            REQUIRE(dynamic.getRef(handles[i]).value == i);
+        }
+    }
+
+    // small batch, compacted by sorting
+    std::vector<TestHandle> few = {handles[1], handles[kStorageSize - 1]};
+    batched->removeN(few);
+    dynamic.removeN(few);
+    for (const TestHandle& handle : few)
+    {
+        REQUIRE(!batched->isValid(handle));
+        REQUIRE(!dynamic.isValid(handle));
+    }
+    for (u32 i = 2; i < kStorageSize - 1; ++i)
+    {
+        if (i % 3 != 0)
+        {
+            REQUIRE(batched->getRef(handles[i]).value == i);
+            REQUIRE(dynamic.getRef(handles[i]).value == i);
+        }
+    }
+
+    u32 sum = 0;
+    batched->forEach([&sum](Item& item) { sum += item.value; });
+    dynamic.forEach([&sum](Item& item) { sum -= item.value; });
+    REQUIRE(sum == 0);
+}
+
+TEST_CASE("Packed free lists forEachParallel", "[freelist]")
+{
+    constexpr u32 kCount = 4 * kFreeListParallelBatchSize + 17;
+
+    auto                                fixed = std::make_unique<PackedFreeList<Item, TestHandle, kCount, true>>();
+    DynPackedFreeList<Item, TestHandle> dynamic;
+    std::vector<TestHandle>             handles(kCount);
+    REQUIRE(fixed->allocN(handles.data(), kCount) == kCount);
+    dynamic.allocN(handles.data(), kCount);
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        fixed->getRef(handles[i]).value  = i;
+        dynamic.getRef(handles[i]).value = i;
+    }
+
+    // holes compacted from the back, so batches don't line up with the allocation order anymore
+    std::vector<TestHandle> removed;
+    for (u32 i = 0; i < kCount; i += 5)
+        removed.push_back(handles[i]);
+    fixed->removeN(removed);
+    dynamic.removeN(removed);
+
+    JobManager jobManager;
+    jobManager.init();
+
+    std::atomic<u32> visited {0};
+    auto             visit = [&visited](Item& item) {
+        item.value = item.value * 2 + 1;
+        ++visited;
+    };
+    fixed->forEachParallel(jobManager, visit);
+    REQUIRE(visited == fixed->storage().count);
+    visited = 0;
+    dynamic.forEachParallel(jobManager, visit);
+    REQUIRE(visited == dynamic.size());
+
+    jobManager.release();
+
+    // every live object visited exactly once
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        if (i % 5 == 0)
+            continue;
+        REQUIRE(fixed->getRef(handles[i]).value == i * 2 + 1);
+        REQUIRE(dynamic.getRef(handles[i]).value == i * 2 + 1);
+    }
+}
+
+TEST_CASE("ChunkedPackedFreeList blocks", "[freelist]")
+{
+    constexpr size_t kBlock = 16;
+    using Storage           = ChunkedPackedFreeList<Item, TestHandle, kBlock, true>;
+    Storage storage;
+
+    // growth across blocks, pointers of earlier objects stay valid
+    std::vector<TestHandle> handles;
+    std::vector<Item*>      pointers;
+    for (u32 i = 0; i < 3 * kBlock + 1; ++i)
+    {
+        handles.push_back(storage.alloc());
+        pointers.push_back(storage.get(handles.back()));
+        pointers.back()->value = i;
+    }
+    REQUIRE(storage.size() == 3 * kBlock + 1);
+    REQUIRE(storage.blockCount() == 4);
+    REQUIRE(storage.blockSize(3) == 1);
+    for (u32 i = 0; i < handles.size(); ++i)
+    {
+        REQUIRE(storage.get(handles[i]) == pointers[i]);
+        REQUIRE(storage.getRef(handles[i]).value == i);
+    }
+
+    // swap-remove inside a block: the last object of block 1 takes the slot, other blocks don't move
+    const TestHandle removed = handles[kBlock + 2];
+    storage.remove(removed);
+    REQUIRE(!storage.isValid(removed));
+    REQUIRE(storage.get(removed) == nullptr);
+    REQUIRE(storage.blockSize(1) == kBlock - 1);
+    REQUIRE(storage.blockData(1)[2].value == 2 * kBlock - 1);
+    REQUIRE(storage.getHandleFromPackedIndex(1, 2) == handles[2 * kBlock - 1]);
+    for (u32 i = 0; i < handles.size(); ++i)
+    {
+        if (handles[i] == removed)
+            continue;
+        REQUIRE(storage.getRef(handles[i]).value == i);
+        if (i / kBlock != 1)
+            REQUIRE(storage.get(handles[i]) == pointers[i]);
+    }
+
+    // the freed slot is reused by the next alloc, in the block that has room
+    const TestHandle reused = storage.alloc();
+    REQUIRE(reused.index() == removed.index());
+    REQUIRE(reused.generation() != removed.generation());
+    storage.remove(reused);
+
+    u32 visited = 0;
+    storage.forEach([&visited](Item&) { ++visited; });
+    REQUIRE(visited == storage.size());
+
+    // allocation fills the partially used blocks first
+    const TestHandle refill = storage.alloc();
+    REQUIRE(refill.index() / kBlock == 1);
+
+    // shrinkToFit releases empty blocks only and keeps their generations
+    for (u32 i = 3 * kBlock; i < handles.size(); ++i)
+        storage.remove(handles[i]);
+    REQUIRE(storage.blockSize(3) == 0);
+    storage.shrinkToFit();
+    REQUIRE(storage.blockData(3) == nullptr);
+    REQUIRE(storage.blockData(0) == pointers[0]);
+    const TestHandle afterShrink = storage.alloc();
+    REQUIRE(afterShrink.index() == handles[3 * kBlock].index());
+    REQUIRE(afterShrink.generation() != handles[3 * kBlock].generation());
+    REQUIRE(!storage.isValid(handles[3 * kBlock]));
+    REQUIRE(storage.getRef(afterShrink).value == 0);
+
+    // clear invalidates every handle and keeps the blocks for the next allocations
+    storage.clear();
+    REQUIRE(storage.size() == 0);
+    for (u32 block = 0; block < storage.blockCount(); ++block)
+        REQUIRE(storage.blockSize(block) == 0);
+    for (const TestHandle& handle : handles)
+        REQUIRE(!storage.isValid(handle));
+    REQUIRE(!storage.isValid(afterShrink));
+    for (u32 i = 0; i < 4 * kBlock; ++i)
+        REQUIRE(storage.isValid(storage.alloc()));
+    REQUIRE(storage.blockCount() == 4);
+    REQUIRE(storage.size() == 4 * kBlock);
+}
+
+TEST_CASE("PackedSoAFreeList columns stay consistent", "[freelist]")
+{
+    struct Position
+    {
+        float x {0.f}, y {0.f}, z {0.f};
+    };
+    struct Mass
+    {
+        double value {0.0};
+    };
+    struct Flags
+    {
+        u8 value {0};
+    };
+    using Storage = PackedSoAFreeList<TestHandle, Position, Mass, Flags>;
+    Storage storage;
+
+    // the three columns of an object are derived from the same value, so a column moved without the others shows
+    auto set = [&storage](TestHandle handle, u32 value) {
+        *storage.get<Position>(handle)   = Position {float(value), float(value) + 0.5f, -float(value)};
+        storage.get<Mass>(handle)->value = value * 2.0;
+        storage.get<2>(handle)->value    = static_cast<u8>(value);
+    };
+    auto check = [&storage](TestHandle handle, u32 value) {
+        REQUIRE(storage.get<0>(handle) == storage.get<Position>(handle));
+        REQUIRE(storage.get<1>(handle) == storage.get<Mass>(handle));
+        REQUIRE(storage.get<Position>(handle)->x == float(value));
+        REQUIRE(storage.get<Position>(handle)->y == float(value) + 0.5f);
+        REQUIRE(storage.get<Position>(handle)->z == -float(value));
+        REQUIRE(storage.get<Mass>(handle)->value == value * 2.0);
+        REQUIRE(storage.get<Flags>(handle)->value == static_cast<u8>(value));
+    };
+
+    std::vector<std::pair<TestHandle, u32>> live;
+    std::mt19937                            rng(7);
+    for (u32 i = 0; i < 4000; ++i)
+    {
+        if (live.empty() || rng() % 3 != 0)
+        {
+            const TestHandle handle = storage.alloc();
+            set(handle, i);
+            live.emplace_back(handle, i);
+        }
+        else
+        {
+            // swap-remove moves the last object of every column
+            const size_t     index  = rng() % live.size();
+            const TestHandle handle = live[index].first;
+            storage.remove(handle);
+            REQUIRE(!storage.isValid(handle));
+            REQUIRE(storage.get<Position>(handle) == nullptr);
+            REQUIRE(storage.get<2>(handle) == nullptr);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+
+    REQUIRE(storage.size() == live.size());
+    for (const auto& [handle, value] : live)
+        check(handle, value);
+
+    // packed columns line up with the handles
+    Span<Position>   positions = storage.column<Position>();
+    Span<const Mass> masses    = static_cast<const Storage&>(storage).column<Mass>();
+    Span<Flags>      flags     = storage.column<2>();
+    REQUIRE(positions.size() == live.size());
+    REQUIRE(masses.size() == live.size());
+    REQUIRE(flags.size() == live.size());
+    for (u32 i = 0; i < storage.size(); ++i)
+    {
+        const TestHandle handle = storage.getHandleFromPackedIndex(i);
+        REQUIRE(storage.getPackedIndex(handle) == i);
+        REQUIRE(&positions[i] == storage.get<Position>(handle));
+        REQUIRE(masses[i].value == positions[i].x * 2.0);
+        REQUIRE(flags[i].value == static_cast<u8>(positions[i].x));
+    }
+
+    // every column starts on kColumnAlignment, also after the storage was reallocated
+    auto aligned = [](const void* p) { return reinterpret_cast<uintptr_t>(p) % Storage::kColumnAlignment == 0; };
+    REQUIRE(aligned(positions.data()));
+    REQUIRE(aligned(masses.data()));
+    REQUIRE(aligned(flags.data()));
+    storage.shrink_to_fit();
+    REQUIRE(aligned(storage.column<Position>().data()));
+    REQUIRE(aligned(storage.column<Mass>().data()));
+    REQUIRE(aligned(storage.column<Flags>().data()));
+    for (const auto& [handle, value] : live)
+        check(handle, value);
+
+    storage.clear();
+    REQUIRE(storage.size() == 0);
+    for (const auto& entry : live)
+        REQUIRE(!storage.isValid(entry.first));
+}
+
+TEST_CASE("ConcurrentFreeList alloc and remove from several threads", "[freelist]")
+{
+    constexpr u32 kThreads    = 4;
+    constexpr u32 kIterations = 20000;
+
+    auto              storage = std::make_unique<ConcurrentFreeList<Item, TestHandle, kStorageSize, true>>();
+    std::atomic<bool> failed {false};
+
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&storage, &failed, t]() {
+            std::vector<TestHandle> owned;
+            std::mt19937            rng(t);
+            for (u32 i = 0; i < kIterations; ++i)
+            {
+                if (owned.size() < kStorageSize / kThreads / 2 && rng() % 2 == 0)
+                {
+                    TestHandle handle = storage->alloc();
+                    if (!handle.valid())
+                        continue;
+                    // nobody else owns this slot, our value must survive other threads work
+                    storage->getRef(handle).value = t + 1;
+                    owned.push_back(handle);
+                }
+                else if (!owned.empty())
+                {
+                    const size_t     index  = rng() % owned.size();
+                    const TestHandle handle = owned[index];
+                    if (storage->getRef(handle).value != t + 1)
+                        failed = true;
+                    storage->remove(handle);
+                    if (storage->isValid(handle))
+                        failed = true;
+                    owned[index] = owned.back();
+                    owned.pop_back();
+                }
+            }
+
+            for (const TestHandle& handle : owned)
+            {
+                if (storage->getRef(handle).value != t + 1)
+                    failed = true;
+                storage->remove(handle);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    REQUIRE(!failed);
+
+    // every index went back either to a thread cache or to the global list
+    std::vector<TestHandle> handles;
+    for (TestHandle handle = storage->alloc(); handle.valid(); handle = storage->alloc())
+        handles.push_back(handle);
+    REQUIRE(handles.size() == kStorageSize);
+}
+
+TEMPLATE_TEST_CASE("Free lists work with 64 bit handles", "[freelist]", (Handle64<32, 32>), (Handle64<24, 24, 8>))
+{
+    using H = TestType;
+
+    REQUIRE(sizeof(H) == 8);
+    H handle(H::MaxIndex, 3);
+    REQUIRE(handle.index() == H::MaxIndex);
+    REQUIRE(handle.generation() == 3);
+    handle.setGeneration(handle.generation() + 1);
+    REQUIRE(handle.index() == H::MaxIndex);
+    REQUIRE(handle.generation() == 4);
+    REQUIRE(!H::invalid.valid());
+
+    checkHandles(*std::make_unique<FreeList<Item, H, kStorageSize, true>>());
+    checkHandles(*std::make_unique<PackedFreeList<Item, H, kStorageSize, true>>());
+    checkHandles(*std::make_unique<ConcurrentFreeList<Item, H, kStorageSize, true>>());
+    checkHandles(*std::make_unique<ChunkedPackedFreeList<Item, H, 256, true>>());
+    DynFreeList<Item, H> dynamic;
+    checkHandles(dynamic);
+    DynPackedFreeList<Item, H> dynamicPacked;
+    checkHandles(dynamicPacked);
+    PackedSoAFreeList<H, Item, float> soa;
+    checkHandles(soa);
+}
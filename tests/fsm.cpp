@@ -0,0 +1,356 @@
+#include "catch.hpp"
+#include "Hq/FSM.h"
+#include "Hq/JsonSerializer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+
+using namespace hq;
+
+namespace
+{
+enum class Transition
+{
+    SeeEnemy,
+    InRange,
+    LostEnemy,
+    Count
+};
+
+struct AiContext
+{
+    std::string log;
+    bool        enemyVisible {false};
+    bool        enemyInRange {false};
+};
+
+struct Idle
+{
+    std::optional<Transition> onEnter(AiContext& context)
+    {
+        context.log += "+idle ";
+        return std::nullopt;
+    }
+    std::optional<Transition> onTick(AiContext& context)
+    {
+        return context.enemyVisible ? std::optional<Transition>(Transition::SeeEnemy) : std::nullopt;
+    }
+    void onExit(AiContext& context)
+    {
+        context.log += "-idle ";
+    }
+};
+
+struct Chase
+{
+    std::optional<Transition> onEnter(AiContext& context)
+    {
+        context.log += "+chase ";
+        // already in range when entering, goes on to Attack
+        return context.enemyInRange ? std::optional<Transition>(Transition::InRange) : std::nullopt;
+    }
+    std::optional<Transition> onTick(AiContext& context)
+    {
+        return context.enemyVisible ? std::nullopt : std::optional<Transition>(Transition::LostEnemy);
+    }
+    void onExit(AiContext& context)
+    {
+        context.log += "-chase ";
+    }
+};
+
+struct Attack
+{
+    std::optional<Transition> onEnter(AiContext& context)
+    {
+        context.log += "+attack ";
+        return std::nullopt;
+    }
+    std::optional<Transition> onTick(AiContext& context)
+    {
+        return context.enemyVisible ? std::nullopt : std::optional<Transition>(Transition::LostEnemy);
+    }
+    void onExit(AiContext& context)
+    {
+        context.log += "-attack ";
+    }
+};
+
+using AiFSM = FSM<AiContext, Transition, Idle, Chase, Attack>;
+
+constexpr AiFSM::TransitionTable kAiTransitions = AiFSM::makeTransitionTable({
+    {Transition::SeeEnemy, AiFSM::stateIndex<Chase>()},
+    {Transition::InRange, AiFSM::stateIndex<Attack>()},
+    {Transition::LostEnemy, AiFSM::stateIndex<Idle>()},
+});
+static_assert(kAiTransitions[static_cast<size_t>(Transition::InRange)] == 2, "table built at compile time");
+}  // namespace
+
+TEST_CASE("FSM follows the transition table", "[fsm]")
+{
+    AiFSM fsm(kAiTransitions);
+    REQUIRE(fsm.isInState<Idle>());
+
+    fsm.tick();
+    REQUIRE(fsm.isInState<Idle>());
+
+    fsm.context().enemyVisible = true;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Chase>());
+    REQUIRE(fsm.context().log == "-idle +chase ");
+
+    fsm.context().enemyVisible = false;
+    fsm.tick();
+    REQUIRE(fsm.currentStateIndex() == AiFSM::stateIndex<Idle>());
+
+    // onEnter of Chase chains to Attack, Chase is left before entering Attack
+    fsm.context().log.clear();
+    fsm.context().enemyVisible = true;
+    fsm.context().enemyInRange = true;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Attack>());
+    REQUIRE(fsm.context().log == "-idle +chase -chase +attack ");
+
+    fsm.changeState<Idle>();
+    REQUIRE(fsm.isInState<Idle>());
+}
+
+TEST_CASE("FSM transitions registered at runtime", "[fsm]")
+{
+    AiFSM fsm;
+    fsm.addTransition<Attack>(Transition::SeeEnemy);
+    fsm.addTransition<Idle>(Transition::LostEnemy);
+
+    fsm.context().enemyVisible = true;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Attack>());
+    fsm.context().enemyVisible = false;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Idle>());
+}
+
+namespace
+{
+enum class Event
+{
+    Engage,
+    InRange,
+    Done,
+    Hit,
+    Recovered,
+    Count
+};
+
+struct Agent
+{
+    std::string          log;
+    std::optional<Event> next;
+};
+
+template <char Name>
+struct AgentState
+{
+    std::optional<Event> onEnter(Agent& agent)
+    {
+        agent.log += std::string("+") + Name;
+        return std::nullopt;
+    }
+    std::optional<Event> onTick(Agent& agent)
+    {
+        return std::exchange(agent.next, std::nullopt);
+    }
+    void onExit(Agent& agent)
+    {
+        agent.log += std::string("-") + Name;
+    }
+};
+
+using Patrol   = AgentState<'p'>;
+using Stunned  = AgentState<'s'>;
+using Approach = AgentState<'a'>;
+using Strike   = AgentState<'k'>;
+
+using CombatMachine = SubMachine<Agent, Event, Approach, Strike>;
+
+constexpr CombatMachine::TransitionTable kCombatTransitions = CombatMachine::makeTransitionTable({
+    {Event::InRange, CombatMachine::stateIndex<Strike>()},
+});
+
+struct Combat : CombatMachine
+{
+    Combat()
+        : SubMachine(kCombatTransitions)
+    {
+    }
+};
+
+using AgentFSM = FSM<Agent, Event, Patrol, Combat, Stunned>;
+
+constexpr AgentFSM::TransitionTable kAgentTransitions = AgentFSM::makeTransitionTable({
+    {Event::Engage, AgentFSM::stateIndex<Combat>()},
+    {Event::Done, AgentFSM::stateIndex<Patrol>()},
+    {Event::Hit, AgentFSM::pushStateIndex<Stunned>()},
+    {Event::Recovered, AgentFSM::kPopState},
+});
+
+size_t index(Event event)
+{
+    return static_cast<size_t>(event);
+}
+}  // namespace
+
+TEST_CASE("FSM pushdown states", "[fsm]")
+{
+    AgentFSM fsm(kAgentTransitions);
+    fsm.pushState<Stunned>();
+    REQUIRE(fsm.isInState<Stunned>());
+    REQUIRE(fsm.stackDepth() == 1);
+
+    // the suspended state is neither left nor entered again
+    fsm.popState();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(fsm.stackDepth() == 0);
+    REQUIRE(fsm.context().log == "+s-s");
+
+    // pushed and popped by transitions
+    fsm.context().log.clear();
+    fsm.context().next = Event::Hit;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Stunned>());
+    fsm.context().next = Event::Recovered;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(fsm.context().log == "+s-s");
+    REQUIRE(fsm.stackErrorCount() == 0);
+}
+
+TEST_CASE("FSM refuses stack overflow and underflow", "[fsm]")
+{
+    AgentFSM fsm(kAgentTransitions);
+    for (size_t i = 0; i < AgentFSM::kMaxStackDepth; ++i)
+        fsm.pushState<Stunned>();
+    REQUIRE(fsm.stackDepth() == AgentFSM::kMaxStackDepth);
+
+    // the push is dropped, the current state is neither left nor entered
+    fsm.context().log.clear();
+    fsm.context().next = Event::Hit;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Stunned>());
+    REQUIRE(fsm.stackDepth() == AgentFSM::kMaxStackDepth);
+    REQUIRE(fsm.stackErrorCount() == 1);
+    REQUIRE(fsm.context().log.empty());
+
+    for (size_t i = 0; i < AgentFSM::kMaxStackDepth; ++i)
+        fsm.popState();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(fsm.stackDepth() == 0);
+
+    // nothing to resume, the current state stays
+    fsm.context().log.clear();
+    fsm.popState();
+    fsm.context().next = Event::Recovered;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(fsm.stackDepth() == 0);
+    REQUIRE(fsm.stackErrorCount() == 3);
+    REQUIRE(fsm.context().log.empty());
+
+    // still usable
+    fsm.pushState<Stunned>();
+    fsm.popState();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(fsm.stackErrorCount() == 3);
+}
+
+TEST_CASE("FSM nested sub-machines and profiling", "[fsm]")
+{
+    AgentFSM   fsm(kAgentTransitions);
+    FSMProfile profile, combatProfile;
+    fsm.setProfile(&profile);
+    fsm.state<Combat>().setProfile(&combatProfile);
+    Agent& agent = fsm.context();
+
+    // entering the sub-machine enters its first state
+    agent.next = Event::Engage;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Combat>());
+    REQUIRE(fsm.state<Combat>().isInState<Approach>());
+    REQUIRE(agent.log == "-p+a");
+
+    // handled inside
+    agent.log.clear();
+    agent.next = Event::InRange;
+    fsm.tick();
+    REQUIRE(fsm.state<Combat>().isInState<Strike>());
+    REQUIRE(agent.log == "-a+k");
+
+    // not handled inside, the parent suspends the whole sub-machine
+    agent.log.clear();
+    agent.next = Event::Hit;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Stunned>());
+    REQUIRE(fsm.stackDepth() == 1);
+    agent.next = Event::Recovered;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Combat>());
+    REQUIRE(fsm.state<Combat>().isInState<Strike>());
+    REQUIRE(agent.log == "+s-s");
+
+    // leaving the sub-machine leaves its current state
+    agent.log.clear();
+    agent.next = Event::Done;
+    fsm.tick();
+    REQUIRE(fsm.isInState<Patrol>());
+    REQUIRE(agent.log == "-k+p");
+
+    const FSMStateProfile& combat = profile.states[AgentFSM::stateIndex<Combat>()];
+    REQUIRE(profile.states.size() == AgentFSM::kStateCount);
+    REQUIRE(!combat.name.empty());
+    REQUIRE(combat.enterCount == 1);
+    REQUIRE(combat.tickCount == 3);
+    REQUIRE(combat.tickTime >= 0.0);
+    REQUIRE(profile.transitionCounts[index(Event::Engage)] == 1);
+    REQUIRE(profile.transitionCounts[index(Event::InRange)] == 0);
+    REQUIRE(profile.transitionCounts[index(Event::Recovered)] == 1);
+    REQUIRE(combatProfile.transitionCounts[index(Event::InRange)] == 1);
+    REQUIRE(combatProfile.states[CombatMachine::stateIndex<Strike>()].enterCount == 1);
+
+    profile.reset();
+    REQUIRE(combat.enterCount == 0);
+    REQUIRE(!combat.name.empty());
+}
+
+TEST_CASE("FSM profile names and JSON export", "[fsm]")
+{
+    AgentFSM   fsm(kAgentTransitions);
+    FSMProfile profile;
+    profile.states.resize(AgentFSM::kStateCount);
+    profile.states[AgentFSM::stateIndex<Stunned>()].name = "Stunned";
+    fsm.setProfile(&profile);
+
+    // readable type names by default, names given before attaching are kept
+    const std::string& combatName = profile.states[AgentFSM::stateIndex<Combat>()].name;
+    REQUIRE(combatName == typeName<Combat>());
+    REQUIRE(combatName.find("Combat") != std::string::npos);
+    REQUIRE(profile.states[AgentFSM::stateIndex<Stunned>()].name == "Stunned");
+
+    fsm.context().next = Event::Engage;
+    fsm.tick();
+    fsm.tick();
+
+    std::stringstream stream;
+    {
+        JsonSerializer serializer(stream);
+        serializer(profile, "agent");
+    }
+    std::string json = stream.str();
+    json.erase(std::remove_if(json.begin(), json.end(), [](char c) { return std::isspace(c); }), json.end());
+
+    REQUIRE(json.find("\"agent\":{") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"Stunned\"") != std::string::npos);
+    REQUIRE(json.find("\"enterCount\":1") != std::string::npos);
+    REQUIRE(json.find("\"tickCount\":1") != std::string::npos);
+    REQUIRE(json.find("\"transitionCounts\":[1,0,0,0,0]") != std::string::npos);
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include "Hq/Hash.h"
+
+#include <bitset>
+#include <unordered_set>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct Key
+{
+    u32   id;
+    u32   layer;
+    float weight;
+    u32   flags;
+};
+
+// chi-squared of `count` hashes spread in `buckets` buckets by the given bits
+template <typename F>
+double chiSquared(u32 count, u32 buckets, F bucketOf)
+{
+    std::vector<u32> histogram(buckets, 0);
+    for (u32 i = 0; i < count; ++i)
+        ++histogram[bucketOf(i)];
+
+    const double expected = double(count) / buckets;
+    double       chi      = 0.0;
+    for (u32 n : histogram)
+        chi += (n - expected) * (n - expected) / expected;
+    return chi;
+}
+}  // namespace
+
+TEST_CASE("make_hash is deterministic and order dependent", "[hash]")
+{
+    REQUIRE(make_hash(1, 2, 3) == make_hash(1, 2, 3));
+    REQUIRE(make_hash(1, 2) != make_hash(2, 1));
+    REQUIRE(make_hash(0) != make_hash(0, 0));
+    REQUIRE(make_hash(0.f) == make_hash(-0.f));
+    REQUIRE(make_hash(StringHash("a")) == make_hash(StringHash("a")));
+
+    size_t seed = 0;
+    hash_combine(seed, 42);
+    REQUIRE(seed != 0);
+
+    Key a {1, 2, 0.5f, 3};
+    Key b = a;
+    REQUIRE(hash_bytes(a) == hash_bytes(b));
+    b.flags = 4;
+    REQUIRE(hash_bytes(a) != hash_bytes(b));
+    REQUIRE(hash_bytes(&a, sizeof(a)) == hash_bytes(a));
+}
+
+TEST_CASE("make_hash spreads grid coordinates evenly", "[hash]")
+{
+    // 256x256 grid, the classic worst case for identity hashes and weak combiners
+    constexpr u32 kSide    = 256;
+    constexpr u32 kCount   = kSide * kSide;
+    constexpr u32 kBuckets = 1024;
+
+    std::unordered_set<size_t> unique;
+    for (u32 i = 0; i < kCount; ++i)
+        unique.insert(make_hash(i % kSide, i / kSide));
+    REQUIRE(unique.size() == kCount);
+
+    // for 1023 degrees of freedom, 1200 is far in the tail of the distribution
+    const double low =
+        chiSquared(kCount, kBuckets, [](u32 i) { return make_hash(i % kSide, i / kSide) & (kBuckets - 1); });
+    const double high =
+        chiSquared(kCount, kBuckets, [](u32 i) { return u64(make_hash(i % kSide, i / kSide)) >> (64 - 10); });
+    REQUIRE(low < 1200.0);
+    REQUIRE(high < 1200.0);
+}
+
+TEST_CASE("make_hash avalanches", "[hash]")
+{
+    // flipping any input bit flips about half of the output bits
+    u64 flipped = 0;
+    u32 tests   = 0;
+    for (u32 value = 0; value < 256; ++value)
+    {
+        const u64 base = make_hash(value, 7u);
+        for (u32 bit = 0; bit < 32; ++bit)
+        {
+            flipped += std::bitset<64>(base ^ make_hash(value ^ (1u << bit), 7u)).count();
+            ++tests;
+        }
+    }
+    const double average = double(flipped) / tests;
+    REQUIRE(average > 30.0);
+    REQUIRE(average < 34.0);
+}
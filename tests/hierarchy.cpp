@@ -0,0 +1,509 @@
+#include "catch.hpp"
+#include "Hq/Ecs/FlatHierarchy.h"
+#include "Hq/Ecs/HierarchicalComponent.h"
+#include "Hq/Ecs/TransformHierarchy.h"
+#include "Hq/Math/Math.h"
+
+#include <random>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct SceneTag
+{
+};
+using SceneNode = HierarchicalComponent<SceneTag>;
+
+// links `child` as last child of `parent`, or leaves it a root
+void link(entt::registry& registry, entt::entity child, entt::entity parent)
+{
+    if (parent != entt::null)
+        Attach<SceneNode>(registry, child, parent);
+}
+
+// checks the flat arrays against the links of the registry
+void checkFlat(entt::registry& registry, const FlatHierarchy<SceneNode>& flat, size_t count)
+{
+    REQUIRE(flat.size() == count);
+    for (u32 i = 0; i < flat.size(); ++i)
+    {
+        const entt::entity entity = flat.entity(i);
+        REQUIRE(flat.indexOf(entity) == i);
+
+        const SceneNode& node = registry.get<SceneNode>(entity);
+        if (node.parent == entt::null)
+        {
+            REQUIRE(flat.parent(i) == FlatHierarchy<SceneNode>::kNoParent);
+            REQUIRE(flat.depth(i) == 0);
+        }
+        else
+        {
+            REQUIRE(flat.parent(i) < i);
+            REQUIRE(flat.entity(flat.parent(i)) == node.parent);
+            REQUIRE(flat.depth(i) == flat.depth(flat.parent(i)) + 1);
+        }
+
+        // the subtree is the contiguous range after the node
+        u32 children = 0;
+        for (entt::entity child = node.firstChild; child != entt::null;
+             child              = registry.get<SceneNode>(child).nextSibling)
+        {
+            const u32 childIndex = flat.indexOf(child);
+            REQUIRE(childIndex > i);
+            REQUIRE(childIndex + flat.subtreeSize(childIndex) <= i + flat.subtreeSize(i));
+            children += flat.subtreeSize(childIndex);
+        }
+        REQUIRE(flat.subtreeSize(i) == children + 1);
+    }
+}
+}  // namespace
+
+TEST_CASE("FlatHierarchy follows the component links", "[hierarchy]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    std::mt19937              rng(5);
+
+    for (u32 i = 0; i < 500; ++i)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        // a few roots, the rest under a random earlier entity
+        link(registry, entity, i % 100 == 0 ? entt::null : entities[rng() % entities.size()]);
+        entities.push_back(entity);
+    }
+
+    FlatHierarchy<SceneNode> flat;
+    flat.build(registry);
+    checkFlat(registry, flat, entities.size());
+
+    // depth-first order on build keeps the sibling order
+    const SceneNode& root = registry.get<SceneNode>(entities[0]);
+    if (root.firstChild != entt::null)
+        REQUIRE(flat.indexOf(root.firstChild) == flat.indexOf(entities[0]) + 1);
+
+    for (u32 i = 0; i < 300; ++i)
+    {
+        const entt::entity entity = entities[rng() % entities.size()];
+        entt::entity       parent = rng() % 10 == 0 ? entt::null : entities[rng() % entities.size()];
+        if (parent != entt::null && IsInHierarchy<SceneNode>(registry, entity, parent))
+            continue;
+
+        Detach<SceneNode>(registry, entity);
+        link(registry, entity, parent);
+        flat.reparent(registry, entity);
+    }
+    checkFlat(registry, flat, entities.size());
+
+    // new leaf, then remove a whole subtree
+    const entt::entity leaf = registry.create();
+    registry.emplace<SceneNode>(leaf);
+    link(registry, leaf, entities[3]);
+    flat.add(registry, leaf);
+    entities.push_back(leaf);
+    checkFlat(registry, flat, entities.size());
+
+    const entt::entity removed = entities[3];
+    const u32          count   = flat.subtreeSize(flat.indexOf(removed));
+    flat.remove(removed);
+    Detach<SceneNode>(registry, removed);
+    REQUIRE(!flat.contains(removed));
+    REQUIRE(!flat.contains(leaf));
+    REQUIRE(flat.size() == entities.size() - count);
+}
+
+TEST_CASE("FlatHierarchy reparent moves subtrees in place", "[hierarchy]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    std::mt19937              rng(21);
+
+    for (u32 i = 0; i < 200; ++i)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        link(registry, entity, i % 40 == 0 ? entt::null : entities[rng() % entities.size()]);
+        entities.push_back(entity);
+    }
+
+    FlatHierarchy<SceneNode> flat;
+    flat.build(registry);
+
+    // forward, backward, to a root, under an ancestor or a sibling, checked after every move
+    for (u32 i = 0; i < 400; ++i)
+    {
+        const entt::entity entity = entities[rng() % entities.size()];
+        entt::entity       parent = rng() % 8 == 0 ? entt::null : entities[rng() % entities.size()];
+        if (parent != entt::null && IsInHierarchy<SceneNode>(registry, entity, parent))
+            continue;
+
+        const u32 count = flat.subtreeSize(flat.indexOf(entity));
+        Detach<SceneNode>(registry, entity);
+        link(registry, entity, parent);
+        flat.reparent(registry, entity);
+        REQUIRE(flat.subtreeSize(flat.indexOf(entity)) == count);
+        checkFlat(registry, flat, entities.size());
+    }
+
+    // children linked under the moved entity before the update are picked up
+    const entt::entity moved = entities[7];
+    const entt::entity child = registry.create();
+    registry.emplace<SceneNode>(child);
+    link(registry, child, moved);
+    entities.push_back(child);
+    Detach<SceneNode>(registry, moved);
+    flat.reparent(registry, moved);
+    REQUIRE(flat.contains(child));
+    checkFlat(registry, flat, entities.size());
+}
+
+TEST_CASE("Hierarchy parallel visits process parents first", "[hierarchy]")
+{
+    // a wide scene: a few deep chains and lots of leaves under the root
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    std::mt19937              rng(11);
+
+    const entt::entity root = registry.create();
+    registry.emplace<SceneNode>(root);
+    link(registry, root, entt::null);
+    entities.push_back(root);
+    for (u32 i = 0; i < 5000; ++i)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        link(registry, entity, i % 4 == 0 ? root : entities[rng() % entities.size()]);
+        entities.push_back(entity);
+    }
+
+    // depth of the parent + 1, only right if the parent was visited before
+    std::vector<u32> depths(entities.size() + 1, 0);
+    auto             entityDepth = [&](entt::entity entity) -> u32& { return depths[entt::to_integral(entity)]; };
+
+    auto visitor = [&](entt::registry& reg, entt::entity entity) {
+        const entt::entity parent = reg.get<SceneNode>(entity).parent;
+        entityDepth(entity)       = parent == entt::null ? 1 : entityDepth(parent) + 1;
+    };
+
+    std::vector<u32> expected;
+    HierarchyFrontier frontier;
+    VisitHierarchyBreadthFirst<SceneNode>(registry, root, visitor, frontier);
+    for (entt::entity entity : entities)
+        expected.push_back(entityDepth(entity));
+
+    JobManager jobManager;
+    jobManager.init();
+
+    std::fill(depths.begin(), depths.end(), 0);
+    VisitHierarchyBreadthFirstParallel<SceneNode>(jobManager, registry, root, visitor, frontier);
+    for (size_t i = 0; i < entities.size(); ++i)
+        REQUIRE(entityDepth(entities[i]) == expected[i]);
+
+    FlatHierarchy<SceneNode> flat;
+    flat.build(registry);
+    std::vector<u32> flatDepths(flat.size(), 0);
+    flat.forEachParallel(jobManager, [&](u32 index, u32 parent) {
+        flatDepths[index] = parent == FlatHierarchy<SceneNode>::kNoParent ? 1 : flatDepths[parent] + 1;
+    });
+    for (u32 i = 0; i < flat.size(); ++i)
+        REQUIRE(flatDepths[i] == entityDepth(flat.entity(i)));
+
+    jobManager.release();
+}
+
+TEST_CASE("TransformHierarchy only updates dirty subtrees", "[hierarchy]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    std::mt19937              rng(3);
+    std::uniform_real_distribution<float> angle(-math::kPi, math::kPi);
+    std::uniform_real_distribution<float> offset(-10.f, 10.f);
+
+    TransformHierarchy<SceneNode> transforms;
+    auto randomLocal = [&](entt::entity entity) {
+        math::Mat4x4 rotation, translation, local;
+        math::createRotation(math::Vec3(0.f, 1.f, 0.f), angle(rng), rotation);
+        math::createTranslation(offset(rng), offset(rng), offset(rng), translation);
+        math::mul(translation, rotation, local);
+        transforms.setLocal(registry, entity, local);
+    };
+
+    for (u32 i = 0; i < 300; ++i)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        link(registry, entity, i % 50 == 0 ? entt::null : entities[rng() % entities.size()]);
+        entities.push_back(entity);
+        randomLocal(entity);
+    }
+
+    // world = parent world * local, recomputed from scratch with the component links
+    auto check = [&]() {
+        for (entt::entity entity : entities)
+        {
+            math::Mat4x4 expected = registry.get<LocalTransform>(entity).matrix;
+            for (entt::entity parent = registry.get<SceneNode>(entity).parent; parent != entt::null;
+                 parent              = registry.get<SceneNode>(parent).parent)
+            {
+                const math::Mat4x4 child = expected;
+                math::mul(registry.get<LocalTransform>(parent).matrix, child, expected);
+            }
+
+            const math::Mat4x4& world = registry.get<WorldTransform>(entity).matrix;
+            for (u32 i = 0; i < 16; ++i)
+                REQUIRE(std::abs(world.data[i] - expected.data[i]) < 1e-3f);
+        }
+    };
+
+    transforms.build(registry);
+    REQUIRE(transforms.update(registry) == entities.size());
+    check();
+    REQUIRE(!transforms.isDirty());
+    REQUIRE(transforms.update(registry) == 0);
+
+    // a leaf only updates itself, a root its whole tree
+    const FlatHierarchy<SceneNode>& flat = transforms.hierarchy();
+    u32                             leaf = 0;
+    while (flat.subtreeSize(leaf) != 1)
+        ++leaf;
+    randomLocal(flat.entity(leaf));
+    REQUIRE(transforms.update(registry) == 1);
+    randomLocal(flat.entity(0));
+    randomLocal(flat.entity(1));
+    REQUIRE(transforms.update(registry) == flat.subtreeSize(0));
+    check();
+
+    for (u32 i = 0; i < 20; ++i)
+        randomLocal(entities[rng() % entities.size()]);
+    transforms.update(registry);
+    check();
+
+    // moved subtrees get the world transform of their new parent
+    const entt::entity moved = entities[7];
+    Detach<SceneNode>(registry, moved);
+    link(registry, moved, entities[0]);
+    transforms.reparent(registry, moved);
+    transforms.update(registry);
+    check();
+}
+
+TEST_CASE("TransformHierarchy structural edits with pending dirty entities", "[hierarchy]")
+{
+    entt::registry                registry;
+    TransformHierarchy<SceneNode> transforms;
+
+    // A(a1, a2, a3) and B, every local transform moves 1 along x except B that moves 5
+    auto create = [&](entt::entity parent) {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        link(registry, entity, parent);
+        math::Mat4x4 local;
+        math::createTranslation(1.f, 0.f, 0.f, local);
+        registry.emplace<LocalTransform>(entity, LocalTransform {local});
+        return entity;
+    };
+    auto worldX = [&](entt::entity entity) { return registry.get<WorldTransform>(entity).matrix.data[12]; };
+    auto moveB  = [&](entt::entity entity) {
+        math::Mat4x4 local;
+        math::createTranslation(5.f, 0.f, 0.f, local);
+        transforms.setLocal(registry, entity, local);
+    };
+
+    const entt::entity a  = create(entt::null);
+    const entt::entity a1 = create(a);
+    const entt::entity a2 = create(a);
+    const entt::entity a3 = create(a);
+    const entt::entity b  = create(entt::null);
+
+    SECTION("reparent while the roots of build are pending")
+    {
+        transforms.build(registry);
+        Detach<SceneNode>(registry, a3);
+        link(registry, a3, b);
+        transforms.reparent(registry, a3);
+        REQUIRE(transforms.update(registry) == 5);
+        REQUIRE(worldX(a1) == 2.f);
+        REQUIRE(worldX(b) == 1.f);
+        REQUIRE(worldX(a3) == 2.f);
+    }
+
+    SECTION("reparent under a dirty entity")
+    {
+        transforms.build(registry);
+        transforms.update(registry);
+        moveB(b);
+        Detach<SceneNode>(registry, a2);
+        link(registry, a2, b);
+        transforms.reparent(registry, a2);
+        REQUIRE(transforms.update(registry) == 2);
+        REQUIRE(worldX(b) == 5.f);
+        REQUIRE(worldX(a2) == 6.f);
+        REQUIRE(worldX(a3) == 2.f);
+    }
+
+    SECTION("remove before a dirty entity")
+    {
+        transforms.build(registry);
+        transforms.update(registry);
+        moveB(b);
+        transforms.markDirty(a1);
+        transforms.remove(a);
+        REQUIRE(transforms.update(registry) == 1);
+        REQUIRE(worldX(b) == 5.f);
+        REQUIRE(transforms.hierarchy().size() == 1);
+    }
+
+    SECTION("add after a dirty entity")
+    {
+        transforms.build(registry);
+        transforms.update(registry);
+        moveB(b);
+        const entt::entity a4 = create(a1);
+        transforms.add(registry, a4);
+        REQUIRE(transforms.update(registry) == 2);
+        REQUIRE(worldX(b) == 5.f);
+        REQUIRE(worldX(a4) == 3.f);
+    }
+}
+
+TEST_CASE("Depth-first visitors order and predicates", "[hierarchy]")
+{
+    // 0
+    // +-- 1
+    // |   +-- 2
+    // |   +-- 3
+    // +-- 4
+    // +-- 5
+    //     +-- 6
+    entt::registry            registry;
+    std::vector<entt::entity> e;
+    const int                 parents[] = {-1, 0, 1, 1, 0, 0, 5};
+    for (int parent : parents)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity);
+        link(registry, entity, parent < 0 ? entt::null : e[parent]);
+        e.push_back(entity);
+    }
+
+    std::vector<entt::entity> visited;
+    auto visitor = [&](entt::registry&, entt::entity entity) { visited.push_back(entity); };
+    HierarchyStack stack;
+
+    VisitHierarchyDepthFirst<SceneNode>(registry, e[0], visitor, stack);
+    REQUIRE(visited == std::vector<entt::entity> {e[0], e[1], e[2], e[3], e[4], e[5], e[6]});
+
+    visited.clear();
+    VisitHierarchyDepthFirstPost<SceneNode>(registry, e[0], visitor, stack);
+    REQUIRE(visited == std::vector<entt::entity> {e[2], e[3], e[1], e[4], e[6], e[5], e[0]});
+
+    // the predicate is asked for every visited entity, not only the root
+    visited.clear();
+    auto predicate = [&](entt::registry&, entt::entity entity) {
+        visited.push_back(entity);
+        return entity != e[1] && entity != e[5];
+    };
+    VisitHierarchyDepthFirstWithPredicate<SceneNode>(registry, e[0], predicate, stack);
+    REQUIRE(visited == std::vector<entt::entity> {e[0], e[1], e[4], e[5]});
+
+    // chains deeper than the call stack could handle recursively
+    // linked by hand, Attach checks for cycles by walking up the whole chain in debug
+    entt::entity previous = e[6];
+    for (u32 i = 0; i < 200000; ++i)
+    {
+        const entt::entity entity = registry.create();
+        registry.emplace<SceneNode>(entity).parent   = previous;
+        registry.get<SceneNode>(previous).firstChild = entity;
+        previous                                     = entity;
+    }
+    u32  count   = 0;
+    auto counter = [&](entt::registry&, entt::entity) { ++count; };
+    VisitHierarchyDepthFirstPost<SceneNode>(registry, e[0], counter, stack);
+    REQUIRE(count == 200007);
+    count = 0;
+    VisitHierarchyDepthFirst<SceneNode>(registry, e[0], counter);
+    REQUIRE(count == 200007);
+}
+
+TEST_CASE("Hierarchy edits keep the sibling links consistent", "[hierarchy]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> e;
+    for (u32 i = 0; i < 6; ++i)
+    {
+        e.push_back(registry.create());
+        registry.emplace<SceneNode>(e.back());
+    }
+
+    auto children = [&](entt::entity parent) {
+        std::vector<entt::entity> result;
+        entt::entity              previous = entt::null;
+        for (entt::entity child = registry.get<SceneNode>(parent).firstChild; child != entt::null;
+             child              = registry.get<SceneNode>(child).nextSibling)
+        {
+            REQUIRE(registry.get<SceneNode>(child).parent == parent);
+            REQUIRE(registry.get<SceneNode>(child).prevSibling == previous);
+            result.push_back(child);
+            previous = child;
+        }
+        return result;
+    };
+
+    Attach<SceneNode>(registry, e[1], e[0]);
+    Attach<SceneNode>(registry, e[2], e[0]);
+    Attach<SceneNode>(registry, e[3], e[0], e[1]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[3], e[1], e[2]});
+
+    MoveBefore<SceneNode>(registry, e[2], e[3]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[2], e[3], e[1]});
+    MoveBefore<SceneNode>(registry, e[3], e[1]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[2], e[3], e[1]});
+
+    Reparent<SceneNode>(registry, e[3], e[2]);
+    Attach<SceneNode>(registry, e[4], e[3]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[2], e[1]});
+    REQUIRE(children(e[2]) == std::vector<entt::entity> {e[3]});
+    REQUIRE(IsInHierarchy<SceneNode>(registry, e[0], e[4]));
+    REQUIRE(!IsInHierarchy<SceneNode>(registry, e[1], e[4]));
+
+    Detach<SceneNode>(registry, e[2]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[1]});
+    REQUIRE(registry.get<SceneNode>(e[2]).parent == entt::null);
+    REQUIRE(children(e[2]) == std::vector<entt::entity> {e[3]});
+
+    // prefab: 2 -> 3 -> 4 with local transforms on 2 and 4
+    math::Mat4x4 matrix = math::Mat4x4::Identity;
+    matrix.data[12]     = 5.f;
+    registry.emplace<LocalTransform>(e[2], LocalTransform {matrix});
+    registry.emplace<LocalTransform>(e[4], LocalTransform {matrix});
+    Attach<SceneNode>(registry, e[5], e[2]);
+
+    const entt::entity copy = InstantiateSubtree<SceneNode, LocalTransform>(registry, e[2], e[0]);
+    REQUIRE(children(e[0]) == std::vector<entt::entity> {e[1], copy});
+
+    const std::vector<entt::entity> copyChildren = children(copy);
+    REQUIRE(copyChildren.size() == 2);
+    REQUIRE(copyChildren[0] != e[3]);
+    REQUIRE(children(copyChildren[0]).size() == 1);
+    REQUIRE(children(copyChildren[1]).empty());
+    const entt::entity copyLeaf = children(copyChildren[0])[0];
+
+    REQUIRE(registry.get<LocalTransform>(copy).matrix.data[12] == 5.f);
+    REQUIRE(registry.get<LocalTransform>(copyLeaf).matrix.data[12] == 5.f);
+    REQUIRE(!registry.any_of<LocalTransform>(copyChildren[0]));
+    // the source is untouched
+    REQUIRE(children(e[2]) == std::vector<entt::entity> {e[3], e[5]});
+
+    // scratch buffers reused between instantiations, a root copy
+    HierarchyCopy      scratch;
+    const entt::entity first  = InstantiateSubtree<SceneNode, LocalTransform>(registry, e[2], e[1], scratch);
+    const entt::entity second = InstantiateSubtree<SceneNode, LocalTransform>(registry, e[3], entt::null, scratch);
+    REQUIRE(children(e[1]) == std::vector<entt::entity> {first});
+    REQUIRE(children(first).size() == 2);
+    REQUIRE(registry.get<SceneNode>(second).parent == entt::null);
+    REQUIRE(children(second).size() == 1);
+    REQUIRE(children(second)[0] != e[4]);
+    REQUIRE(registry.get<LocalTransform>(children(second)[0]).matrix.data[12] == 5.f);
+}
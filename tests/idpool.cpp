@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "Hq/IdPool.h"
+
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace hq;
+
+TEST_CASE("IdPool gives the smallest free id", "[idpool]")
+{
+    IdPool pool(64);
+
+    // grows past the initial capacity
+    for (u32 i = 1; i < 1000; ++i)
+        REQUIRE(pool.getId() == i);
+
+    pool.freeId(500);
+    pool.freeId(10);
+    pool.freeId(10);
+    pool.freeId(0);
+    REQUIRE(pool.getId() == 10);
+    REQUIRE(pool.getId() == 500);
+    REQUIRE(pool.getId() == 1000);
+    REQUIRE(pool.isUsed(0));
+}
+
+TEST_CASE("IdPool matches a reference set", "[idpool]")
+{
+    IdPool        pool;
+    std::set<u32> freeIds;
+    std::set<u32> used;
+    std::mt19937  rng(7);
+    u32           next = 1;
+
+    for (int i = 0; i < 50000; ++i)
+    {
+        if (used.empty() || rng() % 3 != 0)
+        {
+            u32 expected;
+            if (freeIds.empty())
+                expected = next++;
+            else
+            {
+                expected = *freeIds.begin();
+                freeIds.erase(freeIds.begin());
+            }
+            REQUIRE(pool.getId() == expected);
+            used.insert(expected);
+        }
+        else
+        {
+            auto it = used.begin();
+            std::advance(it, rng() % used.size());
+            pool.freeId(*it);
+            freeIds.insert(*it);
+            used.erase(it);
+        }
+    }
+}
+
+TEST_CASE("IdPool getIds returns contiguous ranges", "[idpool]")
+{
+    IdPool pool(256);
+
+    std::vector<Interval> ranges;
+    pool.getIds(100, ranges);
+    REQUIRE(ranges.size() == 1);
+    REQUIRE(ranges[0].left == 1);
+    REQUIRE(ranges[0].right == 101);
+
+    for (u32 id = 20; id < 90; id += 10)
+        pool.freeId(id);
+    pool.freeIds({60, 80});
+
+    // fills the holes first then continues after the last id, across growth
+    ranges.clear();
+    pool.getIds(400, ranges);
+    u32 total = 0;
+    for (const Interval& range : ranges)
+    {
+        for (u32 id = range.left; id < range.right; ++id)
+            REQUIRE(pool.isUsed(id));
+        total += range.right - range.left;
+    }
+    REQUIRE(total == 400);
+    REQUIRE(ranges.front().left == 20);
+    REQUIRE(ranges.back().right == 101 + 400 - 25);
+    REQUIRE(pool.getId() == 101 + 400 - 25);
+}
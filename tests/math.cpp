@@ -1,8 +1,115 @@
 #include "catch.hpp"
+#include "Hq/Math/Mat4x4.h"
 #include "Hq/Math/Math.h"
+#include "Hq/Math/Quat.h"
+#include "Hq/Math/Vec2.h"
+#include "Hq/Math/Vec3.h"
+#include "Hq/Math/Vec4.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
 
 using namespace hq::math;
 
+namespace
+{
+// reference formulas, written element by element like the scalar build, the SIMD paths must match them
+Mat4x4 referenceMul(const Mat4x4& lhs, const Mat4x4& rhs)
+{
+    Mat4x4 dst;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            float sum = 0.f;
+            for (int k = 0; k < 4; ++k)
+                sum += lhs.data[k * 4 + i] * rhs.data[j * 4 + k];
+            dst.data[j * 4 + i] = sum;
+        }
+    }
+    return dst;
+}
+
+Vec4 referenceTransform(const Vec4& v, const Mat4x4& m)
+{
+    Vec4 dst;
+    for (int i = 0; i < 4; ++i)
+        dst.data[i] = v.x * m.data[i] + v.y * m.data[4 + i] + v.z * m.data[8 + i] + v.w * m.data[12 + i];
+    return dst;
+}
+
+// the Quat constructor normalizes, references are built without it
+Quat makeQuat(float x, float y, float z, float w)
+{
+    Quat q;
+    q.x = x;
+    q.y = y;
+    q.z = z;
+    q.w = w;
+    return q;
+}
+
+Quat referenceMul(const Quat& q1, const Quat& q2)
+{
+    return makeQuat(q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
+                    q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x,
+                    q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w,
+                    q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z);
+}
+
+// shortest path, the implementation folds the angle by negating q1
+Quat referenceSlerp(const Quat& q1, const Quat& q2, float t)
+{
+    float       cosTheta = q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+    const float sign     = cosTheta < 0.f ? -1.f : 1.f;
+    cosTheta *= sign;
+    const float theta = std::acos(std::min(cosTheta, 1.f));
+    const float a     = sign * std::sin((1.f - t) * theta) / std::sin(theta);
+    const float b     = std::sin(t * theta) / std::sin(theta);
+    return makeQuat(a * q1.x + b * q2.x, a * q1.y + b * q2.y, a * q1.z + b * q2.z, a * q1.w + b * q2.w);
+}
+
+bool near(const float* lhs, const float* rhs, int count, float tolerance)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (std::abs(lhs[i] - rhs[i]) > tolerance * std::max(1.f, std::abs(rhs[i])))
+            return false;
+    }
+    return true;
+}
+
+bool near(const Mat4x4& lhs, const Mat4x4& rhs, float tolerance = 1e-5f)
+{
+    return near(lhs.data, rhs.data, 16, tolerance);
+}
+
+bool near(const Quat& lhs, const Quat& rhs, float tolerance = 1e-5f)
+{
+    return near(lhs.data, rhs.data, 4, tolerance);
+}
+
+// every element different, so a swapped lane or column shows in the result
+Mat4x4 randomMatrix(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    Mat4x4                                m;
+    for (int i = 0; i < 16; ++i)
+        m.data[i] = dist(rng);
+    // diagonally dominant, always invertible
+    for (int i = 0; i < 4; ++i)
+        m.data[i * 5] += 4.f;
+    return m;
+}
+
+Quat randomRotation(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-kPi, kPi);
+    return createFromEuler(dist(rng), dist(rng), dist(rng));
+}
+}  // namespace
+
 TEST_CASE("Base math functions", "[base math]")
 {
     {
@@ -48,3 +155,145 @@ TEST_CASE("Testing math vectors functions", "[math vectors]")
                  equal(minusV.z, -1.f, kEpsilon)));
     }
 }
+
+TEST_CASE("Mat4x4 operations match the scalar formulas", "[math matrices]")
+{
+    std::mt19937 rng(5);
+    for (int iteration = 0; iteration < 100; ++iteration)
+    {
+        const Mat4x4 a        = randomMatrix(rng);
+        const Mat4x4 b        = randomMatrix(rng);
+        const Mat4x4 expected = referenceMul(a, b);
+
+        Mat4x4 dst;
+        mul(a, b, dst);
+        REQUIRE(near(dst, expected));
+
+        // dst aliasing one of the operands
+        Mat4x4 aliased = a;
+        mul(aliased, b, aliased);
+        REQUIRE(near(aliased, expected));
+        aliased = b;
+        mul(a, aliased, aliased);
+        REQUIRE(near(aliased, expected));
+        aliased = a;
+        mul(aliased, b);
+        REQUIRE(near(aliased, expected));
+
+        Mat4x4 scaled;
+        mul(a, 2.5f, scaled);
+        for (int i = 0; i < 16; ++i)
+            REQUIRE(scaled.data[i] == a.data[i] * 2.5f);
+
+        // invert(M) * M = I, from both sides
+        Mat4x4 inverse;
+        invert(a, inverse);
+        REQUIRE(near(referenceMul(inverse, a), Mat4x4::Identity, 1e-4f));
+        REQUIRE(near(referenceMul(a, inverse), Mat4x4::Identity, 1e-4f));
+        Mat4x4 inPlace = a;
+        invert(inPlace);
+        REQUIRE(near(inPlace, inverse));
+
+        Mat4x4 transposed;
+        transpose(a, transposed);
+        for (int j = 0; j < 4; ++j)
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(transposed.data[j * 4 + i] == a.data[i * 4 + j]);
+        inPlace = a;
+        transpose(inPlace);
+        REQUIRE(inPlace == transposed);
+
+        std::uniform_real_distribution<float> dist(-10.f, 10.f);
+        const Vec4                            v(dist(rng), dist(rng), dist(rng), dist(rng));
+        const Vec4                            expectedV = referenceTransform(v, a);
+        Vec4                                  transformed;
+        transform(v, a, transformed);
+        REQUIRE(near(transformed.data, expectedV.data, 4, 1e-5f));
+        transformed = v;
+        transform(transformed, a);
+        REQUIRE(near(transformed.data, expectedV.data, 4, 1e-5f));
+
+        const Vec3 point(v.x, v.y, v.z);
+        const Vec4 expectedPoint = referenceTransform(Vec4(v.x, v.y, v.z, 1.f), a);
+        Vec3       transformedPoint;
+        transformPoint(point, a, transformedPoint);
+        REQUIRE(near(transformedPoint.data, expectedPoint.data, 3, 1e-5f));
+    }
+}
+
+TEST_CASE("Batched Mat4x4 mul matches single multiplies", "[math matrices]")
+{
+    std::mt19937        rng(11);
+    const Mat4x4        parent = randomMatrix(rng);
+    std::vector<Mat4x4> children(37), results(37);
+    for (Mat4x4& child : children)
+        child = randomMatrix(rng);
+
+    mul(parent, children.data(), results.data(), children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+        REQUIRE(near(results[i], referenceMul(parent, children[i])));
+
+    // in place
+    mul(parent, children.data(), children.data(), children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+        REQUIRE(near(children[i], results[i]));
+}
+
+TEST_CASE("Quat operations match the scalar formulas", "[math quaternions]")
+{
+    std::mt19937 rng(17);
+    for (int iteration = 0; iteration < 100; ++iteration)
+    {
+        const Quat q1 = randomRotation(rng);
+        const Quat q2 = randomRotation(rng);
+
+        const Quat expected = referenceMul(q1, q2);
+        Quat       dst;
+        mul(q1, q2, dst);
+        REQUIRE(near(dst, expected));
+        REQUIRE(near(q1 * q2, expected));
+        Quat aliased = q1;
+        mul(aliased, q2, aliased);
+        REQUIRE(near(aliased, expected));
+        aliased = q2;
+        mul(q1, aliased, aliased);
+        REQUIRE(near(aliased, expected));
+
+        // the ends are returned as given, not folded
+        REQUIRE(near(slerp(q1, q2, 0.f), q1, 0.f));
+        REQUIRE(near(slerp(q1, q2, 1.f), q2, 0.f));
+        for (float t : {0.f, 0.1f, 0.25f, 0.5f, 0.8f, 1.f})
+        {
+            // the fast slerp is a series approximation
+            if (t > 0.f && t < 1.f)
+                REQUIRE(near(slerp(q1, q2, t), referenceSlerp(q1, q2, t), 1e-3f));
+
+            const Quat lerped = lerp(q1, q2, t);
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(std::abs(lerped.data[i] - ((1.f - t) * q1.data[i] + t * q2.data[i])) < 1e-6f);
+        }
+
+        REQUIRE(near(normalize(makeQuat(q1.x * 3.f, q1.y * 3.f, q1.z * 3.f, q1.w * 3.f)), q1));
+        // already normalized, still written to the result
+        REQUIRE(near(normalize(q1), q1));
+    }
+}
+
+TEST_CASE("Vec4 operations match the scalar formulas", "[math vectors]")
+{
+    const Vec4 v(3.f, -4.f, 12.f, 0.f);
+    const Vec4 n = normalize(v);
+    REQUIRE(equal(n.x, 3.f / 13.f, kEpsilon));
+    REQUIRE(equal(n.y, -4.f / 13.f, kEpsilon));
+    REQUIRE(equal(n.z, 12.f / 13.f, kEpsilon));
+    REQUIRE(n.w == 0.f);
+
+    const Vec4 other(1.f, 2.f, -3.f, 4.f);
+    const Vec4 low = minVec(v, other);
+    const Vec4 high = maxVec(v, other);
+    REQUIRE((low.x == 1.f && low.y == -4.f && low.z == -3.f && low.w == 0.f));
+    REQUIRE((high.x == 3.f && high.y == 2.f && high.z == 12.f && high.w == 4.f));
+
+    const Vec4 clamped = clamp(v, Vec4(0.f, -1.f, 0.f, 1.f), Vec4(2.f, 1.f, 5.f, 2.f));
+    REQUIRE((clamped.x == 2.f && clamped.y == -1.f && clamped.z == 5.f && clamped.w == 1.f));
+}
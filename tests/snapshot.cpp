@@ -0,0 +1,333 @@
+#include "catch.hpp"
+#include "Hq/Ecs/HierarchicalComponent.h"
+#include "Hq/Ecs/RegistryDelta.h"
+#include "Hq/Ecs/RegistrySnapshot.h"
+
+#include <cstring>
+#include <random>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+struct Position
+{
+    float x, y, z;
+};
+
+struct Health
+{
+    u16 value;
+    u8  team;
+};
+
+struct Name
+{
+    std::string value;
+
+    template <class Serializer>
+    void Serialize(Serializer& serializer)
+    {
+        SERIALIZE(value);
+    }
+};
+
+struct SceneTag
+{
+};
+
+struct Selected
+{
+};
+using SceneNode = HierarchicalComponent<SceneTag>;
+}  // namespace
+
+TEST_CASE("RegistrySnapshot saves and restores component pools", "[snapshot]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    for (u32 i = 0; i < 1000; ++i)
+    {
+        const entt::entity entity = registry.create();
+        entities.push_back(entity);
+        registry.emplace<Position>(entity, Position {float(i), float(i) * 2.f, 0.f});
+        if (i % 3 == 0)
+            registry.emplace<Name>(entity, Name {"entity " + std::to_string(i)});
+        if (i % 2 == 0)
+        {
+            SceneNode& node = registry.emplace<SceneNode>(entity);
+            if (i > 0)
+                node.parent = entities[0];
+        }
+    }
+    // an entity in a single pool, another one in none
+    const entt::entity named = registry.create();
+    registry.emplace<Name>(named, Name {"named only"});
+    const entt::entity empty = registry.create();
+
+    RegistrySnapshot<Position, Name, SceneNode> snapshot;
+    std::stringstream                           stream;
+    snapshot.save(registry, stream);
+
+    // the world moves on, then rolls back
+    for (u32 i = 0; i < 1000; i += 7)
+        registry.get<Position>(entities[i]).x = -1.f;
+    registry.destroy(entities[5]);
+    registry.emplace<Position>(registry.create(), Position {1.f, 1.f, 1.f});
+
+    REQUIRE(snapshot.restore(registry, stream));
+    REQUIRE(registry.size<Position>() == 1000);
+    REQUIRE(registry.size<Name>() == 335);
+    REQUIRE(registry.size<SceneNode>() == 500);
+    for (u32 i = 0; i < 1000; ++i)
+    {
+        const entt::entity entity = entities[i];
+        REQUIRE(registry.valid(entity));
+        REQUIRE(registry.get<Position>(entity).x == float(i));
+        REQUIRE(registry.get<Position>(entity).y == float(i) * 2.f);
+        REQUIRE(registry.any_of<Name>(entity) == (i % 3 == 0));
+        if (i % 3 == 0)
+            REQUIRE(registry.get<Name>(entity).value == "entity " + std::to_string(i));
+        REQUIRE(registry.any_of<SceneNode>(entity) == (i % 2 == 0));
+        if (i % 2 == 0 && i > 0)
+            REQUIRE(registry.get<SceneNode>(entity).parent == entities[0]);
+    }
+    REQUIRE(registry.get<Name>(named).value == "named only");
+    REQUIRE(!registry.valid(empty));
+
+    // a snapshot of other components is refused
+    std::stringstream other;
+    RegistrySnapshot<Position>().save(registry, other);
+    REQUIRE(!snapshot.restore(registry, other));
+}
+
+TEST_CASE("RegistrySnapshot refuses invalid snapshots", "[snapshot]")
+{
+    entt::registry            registry;
+    std::vector<entt::entity> entities;
+    for (u32 i = 0; i < 100; ++i)
+    {
+        const entt::entity entity = registry.create();
+        entities.push_back(entity);
+        registry.emplace<Position>(entity, Position {float(i), 0.f, 0.f});
+        if (i % 4 == 0)
+            registry.emplace<Selected>(entity);
+    }
+
+    // tag components only save their entities
+    RegistrySnapshot<Position, Selected> snapshot;
+    std::stringstream                    stream;
+    snapshot.save(registry, stream);
+    const std::string saved = stream.str();
+
+    registry.remove<Selected>(entities[0]);
+    registry.emplace<Selected>(entities[1]);
+    REQUIRE(snapshot.restore(registry, stream));
+    REQUIRE(registry.size<Selected>() == 25);
+    REQUIRE(registry.all_of<Selected>(entities[0]));
+    REQUIRE(!registry.all_of<Selected>(entities[1]));
+
+    auto checkUnchanged = [&]() {
+        REQUIRE(registry.size<Position>() == 100);
+        REQUIRE(registry.size<Selected>() == 25);
+        for (u32 i = 0; i < 100; ++i)
+            REQUIRE(registry.get<Position>(entities[i]).x == float(i));
+    };
+
+    // header, then the size and count of the first pool
+    const size_t countOffset = 3 * sizeof(u32) + sizeof(u32);
+    for (u64 count : {u64(1) << 40, ~u64(0), u64(101)})
+    {
+        std::string corrupted = saved;
+        memcpy(&corrupted[countOffset], &count, sizeof(count));
+        std::stringstream in(corrupted);
+        REQUIRE(!snapshot.restore(registry, in));
+        checkUnchanged();
+    }
+
+    // a later pool cut short
+    std::stringstream truncated(saved.substr(0, saved.size() - sizeof(entt::entity)));
+    REQUIRE(!snapshot.restore(registry, truncated));
+    checkUnchanged();
+}
+
+TEST_CASE("RegistryDelta keeps a receiver in sync", "[snapshot]")
+{
+    entt::registry            world, observed;
+    std::vector<entt::entity> alive;
+    std::mt19937              rng(9);
+
+    auto spawn = [&]() {
+        const entt::entity entity = world.create();
+        world.emplace<Position>(entity, Position {float(rng() % 100), 0.f, float(rng() % 100)});
+        if (rng() % 2)
+            world.emplace<Health>(entity, Health {100, u8(rng() % 4)});
+        alive.push_back(entity);
+    };
+
+    auto checkSync = [&]() {
+        REQUIRE(observed.size<Position>() == world.size<Position>());
+        REQUIRE(observed.size<Health>() == world.size<Health>());
+        for (entt::entity entity : alive)
+        {
+            REQUIRE(observed.valid(entity));
+            const Position& p = world.get<Position>(entity);
+            const Position& o = observed.get<Position>(entity);
+            REQUIRE((p.x == o.x && p.y == o.y && p.z == o.z));
+            REQUIRE(observed.any_of<Health>(entity) == world.any_of<Health>(entity));
+            if (world.any_of<Health>(entity))
+            {
+                REQUIRE(observed.get<Health>(entity).value == world.get<Health>(entity).value);
+                REQUIRE(observed.get<Health>(entity).team == world.get<Health>(entity).team);
+            }
+        }
+    };
+
+    for (u32 i = 0; i < 500; ++i)
+        spawn();
+
+    RegistryDelta<Position, Health> encoder, decoder;
+    std::stringstream               stream;
+    encoder.encode(world, stream);
+    const size_t fullSize = stream.str().size();
+    REQUIRE(decoder.apply(observed, stream));
+    checkSync();
+
+    for (u32 tick = 0; tick < 20; ++tick)
+    {
+        // a few entities move, get hit, spawn and die
+        for (u32 i = 0; i < 25; ++i)
+            world.get<Position>(alive[rng() % alive.size()]).x += 1.f;
+        for (u32 i = 0; i < 10; ++i)
+        {
+            const entt::entity entity = alive[rng() % alive.size()];
+            if (Health* health = world.try_get<Health>(entity))
+                health->value -= 1;
+            else
+                world.emplace<Health>(entity, Health {50, 0});
+        }
+        for (u32 i = 0; i < 5; ++i)
+        {
+            const size_t index = rng() % alive.size();
+            world.destroy(alive[index]);
+            alive.erase(alive.begin() + index);
+            spawn();
+        }
+
+        std::stringstream delta;
+        encoder.encode(world, delta);
+        REQUIRE(delta.str().size() < fullSize / 4);
+        REQUIRE(decoder.apply(observed, delta));
+        checkSync();
+    }
+
+    // nothing changed, only run lengths
+    std::stringstream idle;
+    encoder.encode(world, idle);
+    REQUIRE(idle.str().size() < 40);
+    REQUIRE(decoder.apply(observed, idle));
+
+    // a new observer starts from the whole state
+    entt::registry                  late;
+    RegistryDelta<Position, Health> lateDecoder;
+    std::stringstream               full;
+    encoder.reset();
+    encoder.encode(world, full);
+    REQUIRE(lateDecoder.apply(late, full));
+    REQUIRE(late.size<Position>() == world.size<Position>());
+
+    // deltas must be applied in order
+    std::stringstream truncated(full.str().substr(0, full.str().size() / 2));
+    REQUIRE(!RegistryDelta<Position, Health>().apply(late, truncated));
+}
+
+namespace
+{
+using PositionDelta = RegistryDelta<Position, Health>;
+
+// header followed by a hand written payload
+std::string makeDelta(const std::vector<u8>& payload, u64 size)
+{
+    std::stringstream stream;
+    BinarySerializer  serializer(stream);
+    serializer(PositionDelta::kDeltaMagic);
+    serializer(PositionDelta::kDeltaVersion);
+    serializer(u32(2));
+    serializer(size);
+    serializer.write(payload.data(), payload.size());
+    return stream.str();
+}
+
+void appendVarint(std::vector<u8>& bytes, u64 value)
+{
+    for (; value >= 0x80; value >>= 7)
+        bytes.push_back(u8(value | 0x80));
+    bytes.push_back(u8(value));
+}
+}  // namespace
+
+TEST_CASE("RegistryDelta refuses corrupted deltas", "[snapshot]")
+{
+    entt::registry world, observed;
+    for (u32 i = 0; i < 100; ++i)
+        world.emplace<Position>(world.create(), Position {float(i), 0.f, 0.f});
+
+    PositionDelta     encoder, decoder;
+    std::stringstream full;
+    encoder.encode(world, full);
+    REQUIRE(decoder.apply(observed, full));
+
+    // counts too large for the payload, their byte sizes overflow
+    for (u64 count : {u64(1) << 62, ~u64(0) >> 1, u64(1000)})
+    {
+        std::vector<u8> removed;
+        appendVarint(removed, sizeof(Position));
+        appendVarint(removed, count);
+        std::stringstream removedDelta(makeDelta(removed, removed.size()));
+        REQUIRE(!decoder.apply(observed, removedDelta));
+
+        std::vector<u8> added;
+        appendVarint(added, sizeof(Position));
+        appendVarint(added, 0);
+        appendVarint(added, count);
+        std::stringstream addedDelta(makeDelta(added, added.size()));
+        REQUIRE(!decoder.apply(observed, addedDelta));
+    }
+
+    // payload size larger than the stream
+    std::stringstream oversized(makeDelta({1, 2, 3}, u64(1) << 40));
+    REQUIRE(!decoder.apply(observed, oversized));
+
+    // a removed entity unknown to the base
+    std::vector<u8> unknown;
+    appendVarint(unknown, sizeof(Position));
+    appendVarint(unknown, 1);
+    const entt::entity missing = entt::entity(12345);
+    unknown.insert(unknown.end(), reinterpret_cast<const u8*>(&missing),
+                   reinterpret_cast<const u8*>(&missing) + sizeof(missing));
+    std::stringstream unknownDelta(makeDelta(unknown, unknown.size()));
+    REQUIRE(!decoder.apply(observed, unknownDelta));
+
+    // the decoder was reset, it gets back in sync from the whole state
+    for (entt::entity entity : world.view<Position>())
+        world.get<Position>(entity).y = 1.f;
+    observed.clear();
+    encoder.reset();
+    std::stringstream resync;
+    encoder.encode(world, resync);
+    REQUIRE(decoder.apply(observed, resync));
+    REQUIRE(observed.size<Position>() == 100);
+    for (entt::entity entity : world.view<Position>())
+        REQUIRE(observed.get<Position>(entity).y == 1.f);
+
+    // later deltas apply on the new base
+    world.get<Position>(*world.view<Position>().begin()).z = 2.f;
+    std::stringstream next;
+    encoder.encode(world, next);
+    REQUIRE(decoder.apply(observed, next));
+    REQUIRE(observed.get<Position>(*world.view<Position>().begin()).z == 2.f);
+}
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+#include "Hq/StateMachineBank.h"
+
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+enum class DoorState
+{
+    Closed,
+    Opening,
+    Open,
+    Count
+};
+
+struct Door
+{
+    u32 id;
+    u32 timer {0};
+    u32 enterCount {0};
+    u32 leaveCount {0};
+};
+
+using DoorBank = StateMachineBank<DoorState, Door>;
+
+// doors open in 3 ticks, stay open for 5 and close, ids divisible by 10 stay closed
+void addDoorStates(DoorBank& bank)
+{
+    auto enter = [](Door& door) -> DoorBank::ResultType {
+        door.timer = 0;
+        ++door.enterCount;
+        return std::nullopt;
+    };
+    auto leave = [](Door& door) { ++door.leaveCount; };
+
+    bank.addState(DoorState::Closed, enter,
+                  [](Span<Door> doors, Span<DoorBank::ResultType> transitions) {
+                      for (size_t i = 0; i < doors.size(); ++i)
+                      {
+                          if (doors[i].id % 10 != 0)
+                              transitions[i] = DoorState::Opening;
+                      }
+                  },
+                  leave);
+    bank.addState(DoorState::Opening, enter,
+                  [](Span<Door> doors, Span<DoorBank::ResultType> transitions) {
+                      for (size_t i = 0; i < doors.size(); ++i)
+                      {
+                          if (++doors[i].timer == 3)
+                              transitions[i] = DoorState::Open;
+                      }
+                  },
+                  leave);
+    bank.addState(DoorState::Open, enter,
+                  [](Span<Door> doors, Span<DoorBank::ResultType> transitions) {
+                      for (size_t i = 0; i < doors.size(); ++i)
+                      {
+                          if (++doors[i].timer == 5)
+                              transitions[i] = DoorState::Closed;
+                      }
+                  },
+                  leave);
+}
+}  // namespace
+
+TEST_CASE("StateMachineBank groups instances by state", "[statemachine]")
+{
+    DoorBank bank;
+    addDoorStates(bank);
+
+    std::vector<DoorBank::InstanceId> ids;
+    for (u32 i = 0; i < 1000; ++i)
+        ids.push_back(bank.add(DoorState::Closed, Door {i}));
+    REQUIRE(bank.size() == 1000);
+    REQUIRE(bank.count(DoorState::Closed) == 1000);
+
+    bank.tick();
+    REQUIRE(bank.count(DoorState::Closed) == 100);
+    REQUIRE(bank.count(DoorState::Opening) == 900);
+    for (u32 i = 0; i < 1000; ++i)
+    {
+        REQUIRE(bank.context(ids[i]).id == i);
+        REQUIRE(bank.currentState(ids[i]) == (i % 10 == 0 ? DoorState::Closed : DoorState::Opening));
+    }
+
+    for (u32 tick = 0; tick < 3; ++tick)
+        bank.tick();
+    REQUIRE(bank.count(DoorState::Open) == 900);
+    for (Door& door : bank.contexts(DoorState::Open))
+        REQUIRE((door.enterCount == 3 && door.leaveCount == 2));
+
+    // removed instances leave their state, their id is reused
+    bank.remove(ids[1]);
+    REQUIRE(!bank.isValid(ids[1]));
+    REQUIRE(bank.count(DoorState::Open) == 899);
+    const DoorBank::InstanceId reused = bank.add(DoorState::Open, Door {1});
+    REQUIRE(reused == ids[1]);
+    REQUIRE(bank.context(reused).id == 1);
+
+    bank.changeState(ids[0], DoorState::Open);
+    REQUIRE(bank.currentState(ids[0]) == DoorState::Open);
+    REQUIRE(bank.context(ids[0]).leaveCount == 1);
+}
+
+TEST_CASE("StateMachineBank ticks in parallel", "[statemachine]")
+{
+    DoorBank serial, parallel;
+    addDoorStates(serial);
+    addDoorStates(parallel);
+    for (u32 i = 0; i < 5000; ++i)
+    {
+        serial.add(DoorState::Closed, Door {i});
+        parallel.add(DoorState::Closed, Door {i});
+    }
+
+    JobManager jobManager;
+    jobManager.init();
+    for (u32 tick = 0; tick < 12; ++tick)
+    {
+        serial.tick();
+        parallel.tick(jobManager);
+        for (u32 state = 0; state < 3; ++state)
+            REQUIRE(serial.count(DoorState(state)) == parallel.count(DoorState(state)));
+    }
+    jobManager.release();
+
+    for (DoorBank::InstanceId id = 0; id < 5000; ++id)
+    {
+        REQUIRE(serial.currentState(id) == parallel.currentState(id));
+        REQUIRE(serial.context(id).timer == parallel.context(id).timer);
+    }
+}
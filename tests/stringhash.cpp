@@ -0,0 +1,87 @@
+#include "catch.hpp"
+#include "Hq/CompileMurmur.h"
+#include "Hq/StringHash.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace hq;
+
+TEST_CASE("WyHash64 matches the reference vectors", "[stringhash]")
+{
+    const char* inputs[] = {"",
+                            "a",
+                            "abc",
+                            "message digest",
+                            "abcdefghijklmnopqrstuvwxyz",
+                            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+                            "12345678901234567890123456789012345678901234567890123456789012345678901234567890"};
+    const u64   expected[] = {0x0409638ee2bde459ull, 0xa8412d091b5fe0a9ull, 0x32dd92e4b2915153ull,
+                            0x8619124089a3a16bull, 0x7a43afb61d7f5f40ull, 0xff42329b90e50d58ull,
+                            0xc39cab13b115aad3ull};
+
+    for (u64 i = 0; i < 7; ++i)
+        REQUIRE(WyHash64(inputs[i], strlen(inputs[i]), i) == expected[i]);
+}
+
+TEST_CASE("StringHash constructors and hashMany agree", "[stringhash]")
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < 100; ++i)
+        paths.push_back("assets/textures/level_" + std::to_string(i) + "/albedo.png");
+
+    std::vector<std::string_view> views(paths.begin(), paths.end());
+    std::vector<StringHash>       hashes(views.size());
+    hashMany(views, hashes.data());
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        REQUIRE(hashes[i] == StringHash(paths[i]));
+        REQUIRE(hashes[i] == StringHash(paths[i].c_str()));
+        REQUIRE(hashes[i] == StringHash(views[i]));
+    }
+    REQUIRE(!(hashes[0] == hashes[1]));
+}
+
+// literals are computed at compile time and tie the constexpr hashes to the runtime ones
+static_assert("player"_sh.hash() != 0, "_sh must be usable in constant expressions");
+static_assert(compile::murmur3_32("", 0, kStringHashSeed) == MURMUR3_32("", kStringHashSeed), "");
+static_assert(compile::murmur3_32("abc", 3, kStringHashSeed) == MURMUR3_32("abc", kStringHashSeed), "");
+static_assert(compile::murmur3_32("assets/meshes/player.mesh", 25, 0) == MURMUR3_32("assets/meshes/player.mesh"), "");
+static_assert(compile::wyhash64("message digest", 14, 3) == 0x8619124089a3a16bull, "");
+static_assert(compile::wyhash64("12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+                                80, 6) == 0xc39cab13b115aad3ull,
+              "");
+
+TEST_CASE("_sh literals match runtime StringHash", "[stringhash]")
+{
+    REQUIRE(""_sh == StringHash(""));
+    REQUIRE("a"_sh == StringHash("a"));
+    REQUIRE("player"_sh == StringHash("player"));
+    REQUIRE("assets/environments/forest/object_12/materials/variant_3.mat"_sh ==
+            StringHash("assets/environments/forest/object_12/materials/variant_3.mat"));
+
+    // every length around the block sizes of both hashes
+    const std::string text = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ!?abcdefghijklmnopqrstuvwxyz";
+    for (size_t len = 0; len <= text.size(); ++len)
+    {
+        REQUIRE(compile::murmur3_32(text.data(), len, kStringHashSeed) ==
+                MurmurHash3_32(text.data(), static_cast<uint>(len), kStringHashSeed));
+        REQUIRE(compile::wyhash64(text.data(), len, kStringHashSeed) == WyHash64(text.data(), len, kStringHashSeed));
+        REQUIRE(StringHash::fromHash(compileHashString(text.data(), len)) == StringHash(text.substr(0, len)));
+    }
+
+    switch (StringHash("jump"))
+    {
+        case "run"_sh:
+            FAIL();
+            break;
+        case "jump"_sh:
+            SUCCEED();
+            break;
+        default:
+            FAIL();
+    }
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "Hq/StringTable.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hq;
+
+namespace
+{
+u32 collisionsReported = 0;
+
+void onCollision(StringHash, const char*, std::string_view)
+{
+    ++collisionsReported;
+}
+}  // namespace
+
+TEST_CASE("StringTable interns and looks up strings", "[stringtable]")
+{
+    StringTable table;
+    REQUIRE(table.intern("player"));
+    REQUIRE(table.intern("player"));
+    REQUIRE(table.size() == 1);
+    REQUIRE(std::string(table.lookup(StringHash("player"))) == "player");
+    REQUIRE(table.lookup(StringHash("enemy")) == nullptr);
+
+    // big strings go in their own arena block
+    const std::string big(StringTable::kArenaBlockSize, 'x');
+    REQUIRE(table.intern(big));
+    REQUIRE(table.intern("small"));
+    REQUIRE(table.lookup(StringHash(big)) == big);
+    REQUIRE(std::string(table.lookup(StringHash("small"))) == "small");
+}
+
+TEST_CASE("StringTable detects collisions", "[stringtable]")
+{
+    StringTable table;
+    table.setCollisionHandler(onCollision);
+    collisionsReported = 0;
+
+    const StringHash hash = StringHash::fromHash(42);
+    REQUIRE(table.intern("first", hash));
+    REQUIRE(!table.intern("second", hash));
+    REQUIRE(table.collisionCount() == 1);
+    REQUIRE(collisionsReported == 1);
+    REQUIRE(std::string(table.lookup(hash)) == "first");
+}
+
+TEST_CASE("StringTable interns from several threads and saves/loads", "[stringtable]")
+{
+    StringTable              table;
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < 4; ++t)
+    {
+        // threads intern overlapping ranges of names
+        threads.emplace_back([&table, t]() {
+            for (u32 i = 0; i < 5000; ++i)
+                table.intern("entity_" + std::to_string(t * 2500 + i));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    REQUIRE(table.size() == 12500);
+    REQUIRE(table.collisionCount() == 0);
+
+    std::stringstream stream;
+    table.save(stream);
+
+    StringTable loaded;
+    REQUIRE(loaded.load(stream));
+    REQUIRE(loaded.size() == table.size());
+    for (u32 i = 0; i < 12500; ++i)
+    {
+        const std::string name = "entity_" + std::to_string(i);
+        REQUIRE(loaded.lookup(StringHash(name)) == name);
+    }
+
+    std::stringstream garbage("not a string table");
+    REQUIRE(!loaded.load(garbage));
+}